@@ -0,0 +1,298 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+// Microbenchmarks for every enumeration and sampling call of hwinfo. For each call the wall time, the number of heap
+// allocations and the number of syscalls are reported, so that overhead regressions can be tracked between releases.
+//
+// usage: Bench [filter] [min_time_ms]
+//   filter       only run benchmarks whose name contains filter
+//   min_time_ms  minimal runtime of each benchmark (default: 200)
+
+#include <hwinfo/PCIMapper.h>
+#include <hwinfo/hwinfo.h>
+#include <hwinfo/utils/env.h>
+
+#ifdef HWINFO_UNIX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+// =====================================================================================================================
+// allocation counting: every heap allocation of the process goes through these operators
+
+static std::atomic<uint64_t> allocation_count(0);
+
+void* operator new(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+// =====================================================================================================================
+// syscall counting
+
+/**
+ * Counts the syscalls of the calling thread. Uses the raw_syscalls:sys_enter tracepoint via perf_event_open, which
+ * counts every syscall but needs access to tracefs and a permissive perf_event_paranoid. Falls back to the read and
+ * write syscall counters of /proc/thread-self/io (syscr + syscw), which miss open, stat, mmap, ...
+ */
+class SyscallCounter {
+ public:
+  SyscallCounter() {
+#ifdef HWINFO_UNIX
+    const char* id_files[] = {"/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+                              "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"};
+    for (const char* id_file : id_files) {
+      std::ifstream file(id_file);
+      uint64_t id = 0;
+      if (!(file >> id)) {
+        continue;
+      }
+      perf_event_attr attr{};
+      attr.type = PERF_TYPE_TRACEPOINT;
+      attr.size = sizeof(attr);
+      attr.config = id;
+      attr.exclude_kernel = 0;
+      _perf_fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+      if (_perf_fd >= 0) {
+        ioctl(_perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+        break;
+      }
+    }
+#endif
+  }
+
+  ~SyscallCounter() {
+#ifdef HWINFO_UNIX
+    if (_perf_fd >= 0) {
+      close(_perf_fd);
+    }
+#endif
+  }
+
+  bool exact() const { return _perf_fd >= 0; }
+
+  // -1 if syscalls cannot be counted at all
+  int64_t read() const {
+#ifdef HWINFO_UNIX
+    if (_perf_fd >= 0) {
+      uint64_t count = 0;
+      if (::read(_perf_fd, &count, sizeof(count)) != sizeof(count)) {
+        return -1;
+      }
+      return static_cast<int64_t>(count);
+    }
+    std::ifstream io("/proc/thread-self/io");
+    std::string key;
+    int64_t value = 0;
+    int64_t count = 0;
+    bool found = false;
+    while (io >> key >> value) {
+      if (key == "syscr:" || key == "syscw:") {
+        count += value;
+        found = true;
+      }
+    }
+    return found ? count : -1;
+#else
+    return -1;
+#endif
+  }
+
+ private:
+  int _perf_fd{-1};
+};
+
+// =====================================================================================================================
+// benchmark runner
+
+struct Benchmark {
+  std::string name;
+  std::function<void()> call;
+};
+
+struct Measurement {
+  int64_t iterations{0};
+  double wall_us{0};
+  double allocations{0};
+  double syscalls{-1};
+};
+
+// _____________________________________________________________________________________________________________________
+Measurement run(const Benchmark& benchmark, const SyscallCounter& syscalls, double min_time_ms, double counter_cost) {
+  typedef std::chrono::steady_clock clock;
+  // warm up: lazily initialized state (caches, jiffies, ...) must not end up in the measurement
+  benchmark.call();
+
+  Measurement measurement;
+  const uint64_t allocations_before = allocation_count.load();
+  const int64_t syscalls_before = syscalls.read();
+  const auto start = clock::now();
+  auto now = start;
+  do {
+    benchmark.call();
+    measurement.iterations++;
+    now = clock::now();
+  } while (std::chrono::duration<double, std::milli>(now - start).count() < min_time_ms);
+  const int64_t syscalls_after = syscalls.read();
+  const uint64_t allocations_after = allocation_count.load();
+
+  const auto iterations = static_cast<double>(measurement.iterations);
+  measurement.wall_us = std::chrono::duration<double, std::micro>(now - start).count() / iterations;
+  measurement.allocations = static_cast<double>(allocations_after - allocations_before) / iterations;
+  if (syscalls_before >= 0 && syscalls_after >= 0) {
+    // reading the counter itself costs syscalls
+    measurement.syscalls = (static_cast<double>(syscalls_after - syscalls_before) - counter_cost) / iterations;
+  }
+  return measurement;
+}
+
+// _____________________________________________________________________________________________________________________
+int main(int argc, char** argv) {
+  const std::string filter = argc > 1 ? argv[1] : "";
+  const double min_time_ms = argc > 2 ? std::atof(argv[2]) : 200.0;
+
+  std::vector<Benchmark> benchmarks;
+  benchmarks.push_back({"getAllCPUs", [] { hwinfo::getAllCPUs(); }});
+  benchmarks.push_back({"getAllGPUs", [] { hwinfo::getAllGPUs(); }});
+  benchmarks.push_back({"getAllDisks", [] { hwinfo::getAllDisks(); }});
+  benchmarks.push_back({"getAllBatteries", [] { hwinfo::getAllBatteries(); }});
+#ifdef HWINFO_UNIX
+  benchmarks.push_back({"getAllPCIDevices", [] { hwinfo::getAllPCIDevices(); }});
+  benchmarks.push_back({"getAllUSBDevices", [] { hwinfo::getAllUSBDevices(); }});
+  benchmarks.push_back({"getGPUProcesses", [] { hwinfo::getGPUProcesses(); }});
+#endif
+  benchmarks.push_back({"RAM()", [] { hwinfo::RAM ram; }});
+#ifdef HWINFO_UNIX
+  benchmarks.push_back({"getMemInfo", [] { hwinfo::getMemInfo(); }});
+  static const hwinfo::MemInfoSampler meminfo_sampler;
+  benchmarks.push_back({"MemInfoSampler::sample", [] { meminfo_sampler.sample(); }});
+  static hwinfo::VMStatSampler vmstat_sampler;
+  benchmarks.push_back({"VMStatSampler::sample", [] { vmstat_sampler.sample(); }});
+  benchmarks.push_back({"getPressure(Memory)", [] { hwinfo::getPressure(hwinfo::PressureResource::Memory); }});
+#endif
+  benchmarks.push_back({"OS()", [] { hwinfo::OS os; }});
+  benchmarks.push_back({"OS::fullName/name/version/kernel", [] {
+                          hwinfo::OS os;
+                          os.fullName();
+                          os.name();
+                          os.version();
+                          os.kernel();
+                        }});
+  benchmarks.push_back({"MainBoard()", [] { hwinfo::MainBoard main_board; }});
+  benchmarks.push_back({"PCI::getMapper", [] { hwinfo::PCI::getMapper(); }});
+
+  auto cpus = hwinfo::getAllCPUs();
+  if (!cpus.empty()) {
+    const hwinfo::CPU& cpu = cpus[0];
+    benchmarks.push_back({"CPU::currentClockSpeed_MHz()", [&cpu] { cpu.currentClockSpeed_MHz(); }});
+    benchmarks.push_back({"CPU::currentClockSpeed_MHz(0)", [&cpu] { cpu.currentClockSpeed_MHz(0); }});
+    benchmarks.push_back({"CPU::currentUtilisation", [&cpu] { cpu.currentUtilisation(); }});
+    benchmarks.push_back({"CPU::threadUtilisation(0)", [&cpu] { cpu.threadUtilisation(0); }});
+    benchmarks.push_back({"CPU::threadsUtilisation", [&cpu] { cpu.threadsUtilisation(); }});
+  }
+
+  auto batteries = hwinfo::getAllBatteries();
+  if (!batteries.empty()) {
+    hwinfo::Battery& battery = batteries[0];
+    benchmarks.push_back({"Battery::energyNow", [&battery] { (void)battery.energyNow(); }});
+    benchmarks.push_back({"Battery::charging", [&battery] { (void)battery.charging(); }});
+  }
+
+#ifdef HWINFO_UNIX
+  static hwinfo::GPUSampler gpu_sampler;
+  if (gpu_sampler.size() > 0) {
+    benchmarks.push_back({"GPUSampler::sample", [] { gpu_sampler.sample(); }});
+  }
+
+  const std::string pci_ids(hwinfo::utils::get_hwinfo_directory() + "/pci.ids");
+  if (std::ifstream(pci_ids)) {
+    // construction and memory of the PCIMapper modes: see PCIBench
+    static const hwinfo::PCIMapper mapper(pci_ids);
+    benchmarks.push_back({"PCIMapper lookup (vendor, device)", [] {
+                            const hwinfo::PCIVendor& vendor = mapper["10de"];
+                            const hwinfo::PCIDevice& device = vendor["2484"];
+                            (void)device;
+                          }});
+    // fleet dump like input: every vendor/device pair of the database, each with its first subsystem
+    static std::vector<hwinfo::PCIIds> ids;
+    static std::vector<hwinfo::PCINames> names;
+    for (size_t v = 0; v < mapper.num_vendors(); ++v) {
+      const hwinfo::PCIVendor vendor = mapper.vendor_at(v);
+      for (size_t d = 0; d < vendor.num_devices(); ++d) {
+        const hwinfo::PCIDevice device = vendor.device_at(d);
+        hwinfo::PCISubsystem subsystem =
+            device.num_subsystems() > 0 ? device.subsystem_at(0) : hwinfo::PCISubsystem{0, 0, nullptr};
+        ids.push_back({vendor.vendor_id, device.device_id, subsystem.subvendor_id, subsystem.subdevice_id});
+      }
+    }
+    names.resize(ids.size());
+    benchmarks.push_back({"PCIMapper::resolve batch (" + std::to_string(ids.size()) + ")",
+                          [] { mapper.resolve(ids.data(), ids.size(), names.data()); }});
+  }
+#endif
+
+  SyscallCounter syscalls;
+  // syscalls needed to read the counter twice
+  int64_t counter_cost = 0;
+  {
+    int64_t first = syscalls.read();
+    int64_t second = syscalls.read();
+    if (first >= 0 && second >= 0) {
+      counter_cost = second - first;
+    }
+  }
+
+  std::cout << "syscall counter: "
+            << (syscalls.exact() ? "raw_syscalls:sys_enter tracepoint" : "/proc/thread-self/io (read/write only)")
+            << "\n\n";
+  std::cout << std::left << std::setw(40) << "benchmark" << std::right << std::setw(12) << "iterations"
+            << std::setw(14) << "wall [us]" << std::setw(14) << "allocations" << std::setw(12) << "syscalls"
+            << '\n';
+  std::cout << std::string(92, '-') << '\n';
+  for (const auto& benchmark : benchmarks) {
+    if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) {
+      continue;
+    }
+    Measurement measurement = run(benchmark, syscalls, min_time_ms, static_cast<double>(counter_cost));
+    std::cout << std::left << std::setw(40) << benchmark.name << std::right << std::setw(12) << measurement.iterations
+              << std::fixed << std::setprecision(2) << std::setw(14) << measurement.wall_us << std::setw(14)
+              << measurement.allocations << std::setw(12);
+    if (measurement.syscalls < 0) {
+      std::cout << "n/a";
+    } else {
+      std::cout << measurement.syscalls;
+    }
+    std::cout << '\n';
+  }
+  return 0;
+}
@@ -0,0 +1,283 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+// Benchmark of the PCI ID database: construction time, lookup latency and memory footprint of PCIMapper in each of
+// its modes (text eager/lazy, binary index, compiled in tables). Every mode runs in a forked child process, so that
+// the resident memory of one mode is not hidden by pages another mode already touched or left in the malloc arenas.
+//
+// usage: PCIBench [pci.ids] [repetitions]
+//   pci.ids      database to read (default: $HOME/.hwinfo/pci.ids)
+//   repetitions  number of constructions and warm lookup passes per mode (default: 20)
+
+#include <fcntl.h>
+#include <hwinfo/PCIMapper.h>
+#include <hwinfo/utils/env.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// =====================================================================================================================
+// heap accounting: every allocation carries its size in a header, so that the bytes still allocated can be tracked
+
+static std::atomic<int64_t> heap_bytes(0);
+
+// keeps the returned pointer aligned for any fundamental type
+static constexpr std::size_t header_size = alignof(std::max_align_t) > sizeof(std::size_t) ? alignof(std::max_align_t)
+                                                                                            : sizeof(std::size_t);
+
+void* operator new(std::size_t size) {
+  auto* block = static_cast<char*>(std::malloc(size + header_size));
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+  *reinterpret_cast<std::size_t*>(block) = size;
+  heap_bytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+  return block + header_size;
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void* ptr) noexcept {
+  if (ptr == nullptr) {
+    return;
+  }
+  char* block = static_cast<char*>(ptr) - header_size;
+  heap_bytes.fetch_sub(static_cast<int64_t>(*reinterpret_cast<std::size_t*>(block)), std::memory_order_relaxed);
+  std::free(block);
+}
+
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { operator delete(ptr); }
+
+void operator delete[](void* ptr, std::size_t) noexcept { operator delete(ptr); }
+
+// =====================================================================================================================
+// helpers
+
+typedef std::chrono::steady_clock bench_clock;
+
+// _____________________________________________________________________________________________________________________
+double elapsed_us(bench_clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(bench_clock::now() - start).count();
+}
+
+// _____________________________________________________________________________________________________________________
+int64_t resident_bytes() {
+  // second field of /proc/self/statm: resident pages (anonymous and file backed)
+  std::ifstream statm("/proc/self/statm");
+  int64_t size = 0;
+  int64_t resident = 0;
+  if (!(statm >> size >> resident)) {
+    return -1;
+  }
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+// _____________________________________________________________________________________________________________________
+void drop_page_cache(const std::string& path) {
+  // best effort: clean pages of the file are dropped, so that the next access has to read from the device
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+double median(std::vector<double> values) {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+// =====================================================================================================================
+// modes
+
+struct Mode {
+  std::string name;
+  // files read by the mode, dropped from the page cache before the cold lookups
+  std::vector<std::string> files;
+  // called before every construction, not measured
+  std::function<void()> prepare;
+  std::function<std::shared_ptr<const hwinfo::IDMapper>()> build;
+};
+
+struct Result {
+  double construct_us{0};
+  int64_t heap_bytes{0};
+  int64_t rss_construct_bytes{0};
+  int64_t rss_lookup_bytes{0};
+  double cold_lookup_ns{0};
+  double warm_lookup_ns{0};
+};
+
+// _____________________________________________________________________________________________________________________
+double lookup_pass(const hwinfo::IDMapper& mapper, const std::vector<hwinfo::PCIIds>& ids) {
+  const auto start = bench_clock::now();
+  size_t resolved = 0;
+  for (const auto& id : ids) {
+    resolved += mapper.resolve(id).device != nullptr;
+  }
+  const double ns = elapsed_us(start) * 1000.0 / static_cast<double>(ids.size());
+  // keep the lookups from being optimized away
+  if (resolved > ids.size()) {
+    std::abort();
+  }
+  return ns;
+}
+
+// _____________________________________________________________________________________________________________________
+Result measure(const Mode& mode, const std::vector<hwinfo::PCIIds>& ids, int repetitions) {
+  Result result;
+  {
+    // memory and cold lookups on the first mapper of the process
+    for (const auto& file : mode.files) {
+      drop_page_cache(file);
+    }
+    mode.prepare();
+    const int64_t rss_before = resident_bytes();
+    const int64_t heap_before = heap_bytes.load();
+    std::shared_ptr<const hwinfo::IDMapper> mapper = mode.build();
+    result.heap_bytes = heap_bytes.load() - heap_before;
+    result.rss_construct_bytes = resident_bytes() - rss_before;
+    result.cold_lookup_ns = lookup_pass(*mapper, ids);
+    std::vector<double> warm;
+    for (int i = 0; i < repetitions; ++i) {
+      warm.push_back(lookup_pass(*mapper, ids));
+    }
+    result.warm_lookup_ns = median(warm);
+    result.rss_lookup_bytes = resident_bytes() - rss_before;
+  }
+  std::vector<double> construct;
+  for (int i = 0; i < repetitions; ++i) {
+    mode.prepare();
+    const auto start = bench_clock::now();
+    std::shared_ptr<const hwinfo::IDMapper> mapper = mode.build();
+    construct.push_back(elapsed_us(start));
+  }
+  result.construct_us = median(construct);
+  return result;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<hwinfo::PCIIds> sample_ids(const hwinfo::IDMapper& mapper, size_t count) {
+  // (vendor, device, first subsystem) of random devices, the same for every mode
+  std::vector<hwinfo::PCIIds> all;
+  for (size_t v = 0; v < mapper.num_vendors(); ++v) {
+    const hwinfo::PCIVendor vendor = mapper.vendor_at(v);
+    for (size_t d = 0; d < vendor.num_devices(); ++d) {
+      const hwinfo::PCIDevice device = vendor.device_at(d);
+      hwinfo::PCISubsystem subsystem =
+          device.num_subsystems() > 0 ? device.subsystem_at(0) : hwinfo::PCISubsystem{0, 0, nullptr};
+      all.push_back({vendor.vendor_id, device.device_id, subsystem.subvendor_id, subsystem.subdevice_id});
+    }
+  }
+  std::vector<hwinfo::PCIIds> ids;
+  if (all.empty()) {
+    return ids;
+  }
+  std::mt19937 random(42);
+  std::uniform_int_distribution<size_t> pick(0, all.size() - 1);
+  for (size_t i = 0; i < count; ++i) {
+    ids.push_back(all[pick(random)]);
+  }
+  return ids;
+}
+
+// _____________________________________________________________________________________________________________________
+int main(int argc, char** argv) {
+  const std::string pci_ids = argc > 1 ? argv[1] : hwinfo::utils::get_hwinfo_directory() + "/pci.ids";
+  const int repetitions = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+  const std::string index_file = "/tmp/hwinfo_pci_bench_" + std::to_string(getpid()) + ".idx";
+  const bool has_text = static_cast<bool>(std::ifstream(pci_ids));
+
+  std::vector<Mode> modes;
+  const auto nothing = [] {};
+  if (has_text) {
+    modes.push_back({"text (eager)", {pci_ids}, nothing,
+                     [&pci_ids] { return std::make_shared<const hwinfo::PCIMapper>(pci_ids); }});
+    modes.push_back({"text (lazy)", {pci_ids}, nothing, [&pci_ids] {
+                       return std::make_shared<const hwinfo::PCIMapper>(pci_ids, hwinfo::PCIParseMode::Lazy);
+                     }});
+    // first process on a machine: parses pci.ids and writes the index
+    modes.push_back({"index (write)", {pci_ids}, [&index_file] { std::remove(index_file.c_str()); },
+                     [&pci_ids, &index_file] {
+                       return std::make_shared<const hwinfo::PCIMapper>(pci_ids, index_file);
+                     }});
+    // every later process: maps the index
+    modes.push_back({"index (mapped)", {pci_ids, index_file}, nothing,
+                     [&pci_ids, &index_file] {
+                       return std::make_shared<const hwinfo::PCIMapper>(pci_ids, index_file);
+                     }});
+  }
+#ifdef HWINFO_EMBED_PCI_IDS
+  modes.push_back({"embedded", {}, nothing, [] { return hwinfo::pci::embedded_mapper(); }});
+#endif
+  if (modes.empty()) {
+    std::cerr << "pci.ids not found: " << pci_ids << '\n';
+    return 1;
+  }
+
+  std::vector<hwinfo::PCIIds> ids;
+  {
+    std::shared_ptr<const hwinfo::IDMapper> mapper = modes[0].build();
+    ids = sample_ids(*mapper, 1024);
+  }
+  if (ids.empty()) {
+    std::cerr << "no devices in the PCI ID database\n";
+    return 1;
+  }
+
+  std::cout << "source: " << (has_text ? pci_ids : "compiled in tables") << ", " << ids.size()
+            << " random lookups per pass, " << repetitions << " repetitions\n";
+  std::cout << "cold: first pass after construction, files dropped from the page cache (best effort)\n\n";
+  std::cout << std::left << std::setw(16) << "mode" << std::right << std::setw(16) << "construct [us]" << std::setw(12)
+            << "heap [KiB]" << std::setw(12) << "RSS [KiB]" << std::setw(16) << "cold [ns/op]" << std::setw(16)
+            << "warm [ns/op]" << std::setw(24) << "RSS after lookups [KiB]" << '\n';
+  std::cout << std::string(112, '-') << std::endl;
+  for (const auto& mode : modes) {
+    if (mode.name == "index (mapped)") {
+      // make sure the index exists, whatever ran before
+      mode.build();
+    }
+    pid_t child = fork();
+    if (child < 0) {
+      std::perror("fork");
+      return 1;
+    }
+    if (child == 0) {
+      Result result = measure(mode, ids, repetitions);
+      std::cout << std::left << std::setw(16) << mode.name << std::right << std::fixed << std::setprecision(1)
+                << std::setw(16) << result.construct_us << std::setw(12) << result.heap_bytes / 1024 << std::setw(12)
+                << result.rss_construct_bytes / 1024 << std::setw(16) << result.cold_lookup_ns << std::setw(16)
+                << result.warm_lookup_ns << std::setw(24) << result.rss_lookup_bytes / 1024 << std::endl;
+      _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      std::cerr << mode.name << ": benchmark process failed\n";
+    }
+  }
+  std::remove(index_file.c_str());
+  return 0;
+}
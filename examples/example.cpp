@@ -66,6 +66,8 @@ int main(int argc, char** argv) {
     std::cout << gpu.vendor() << std::endl;
     std::cout << std::left << std::setw(20) << "  model:";
     std::cout << gpu.name() << std::endl;
+    std::cout << std::left << std::setw(20) << "  PCI address:";
+    std::cout << gpu.pciAddress() << std::endl;
     std::cout << std::left << std::setw(20) << "  driverVersion:";
     std::cout << gpu.driverVersion() << std::endl;
     std::cout << std::left << std::setw(20) << "  memory [MiB]:";
@@ -86,6 +88,8 @@ int main(int argc, char** argv) {
   std::cout << ram.name() << std::endl;
   std::cout << std::left << std::setw(20) << "serial-number:";
   std::cout << ram.serialNumber() << std::endl;
+  std::cout << std::left << std::setw(20) << "speed [MT/s]:";
+  std::cout << ram.speed_MTps() << std::endl;
   std::cout << std::left << std::setw(20) << "size [MiB]:";
   std::cout << ram.total_Bytes() / 1024 / 1024 << std::endl;
   std::cout << std::left << std::setw(20) << "free [MiB]:";
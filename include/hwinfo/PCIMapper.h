@@ -7,132 +7,1252 @@
 
 #pragma once
 
+#include "platform.h"
+
+#if defined(HWINFO_UNIX) || defined(HWINFO_APPLE)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(HWINFO_WINDOWS)
+#include <process.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
-#include <map>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
-#include "utils/stringutils.h"
+#include "utils/env.h"
 
 namespace hwinfo {
 
-struct PCIDevice {
-  PCIDevice(std::string d_id, std::string d_name)
-      : device_id(std::move(d_id)), device_name(std::move(d_name)) {}
+// ---------------------------------------------------------------------------------------------------------------------
+// Flat PCI ID database: vendors, devices and subsystems live in three sorted arrays of plain records, all names in one
+// string arena (NUL terminated, referenced by offset). A vendor refers to its devices and a device to its subsystems
+// by a range in the next array, so a lookup is a binary search over 16 bit keys and no node based containers are
+// involved. Tables compiled into the binary (HWINFO_EMBED_PCI_IDS) reference names by index into a table of string
+// literals instead, as compilers limit the length of a single literal.
+
+struct PCIVendorRecord {
+  uint16_t id;
+  uint32_t name;
+  uint32_t first_device;
+  uint32_t num_devices;
+};
+
+struct PCIDeviceRecord {
+  uint16_t id;
+  uint32_t name;
+  uint32_t first_subsystem;
+  uint32_t num_subsystems;
+};
+
+struct PCISubsystemRecord {
+  uint16_t subvendor_id;
+  uint16_t subdevice_id;
+  uint32_t name;
+};
+
+// entry of the class section: key is level << 24 | class << 16 | subclass << 8 | prog-if, level 0 (class),
+// 1 (subclass) or 2 (programming interface); the fields below the level are 0
+struct PCIClassRecord {
+  uint32_t key;
+  uint32_t name;
+};
+
+namespace pci {
+
+/**
+ * Parse a 16 bit PCI id given as hex string with optional "0x" prefix ("10de", "0x10de"). Trailing whitespace is
+ * ignored. Returns -1 if id is not a valid id.
+ */
+inline int32_t parse_id(const char* id, size_t size) {
+  size_t i = 0;
+  if (size >= 2 && id[0] == '0' && (id[1] == 'x' || id[1] == 'X')) {
+    i = 2;
+  }
+  int32_t value = 0;
+  size_t digits = 0;
+  for (; i < size; ++i, ++digits) {
+    char c = id[i];
+    int32_t digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      break;
+    }
+    value = value * 16 + digit;
+  }
+  for (; i < size; ++i) {
+    if (id[i] != ' ' && id[i] != '\t' && id[i] != '\n' && id[i] != '\r') {
+      return -1;
+    }
+  }
+  return (digits == 0 || digits > 4) ? -1 : value;
+}
+
+inline int32_t parse_id(const std::string& id) { return parse_id(id.data(), id.size()); }
+
+/**
+ * Resolves the name field of a record: an offset into arena, or an index into table if the tables are embedded.
+ */
+struct Names {
+  const char* arena;
+  const char* const* table;
+
+  const char* operator[](uint32_t name) const { return table != nullptr ? table[name] : arena + name; }
+};
+
+inline uint32_t class_key(uint32_t level, uint32_t class_code) { return level << 24 | (class_code & 0xffffff); }
+
+/**
+ * Find the record with key id in the sorted range [first, first + count), nullptr if there is none.
+ */
+template <typename Record>
+inline Record* find_record(Record* first, size_t count, uint16_t id) {
+  Record* last = first + count;
+  Record* it =
+      std::lower_bound(first, last, id, [](const Record& record, uint16_t key) { return record.id < key; });
+  return (it != last && it->id == id) ? it : nullptr;
+}
+
+}  // namespace pci
+
+// numeric identification of a PCI function, as in its config space
+struct PCIIds {
+  uint16_t vendor_id;
+  uint16_t device_id;
+  uint16_t subvendor_id;
+  uint16_t subdevice_id;
+};
+
+// names resolved by IDMapper::resolve(), pointing into the mapper
+struct PCINames {
+  const char* vendor;
+  const char* device;
+  const char* subsystem;
+};
+
+// names of a class code resolved by IDMapper::resolve_class(), nullptr if unknown
+struct PCIClassNames {
+  // "Display controller"
+  const char* base_class;
+  // "VGA compatible controller"
+  const char* subclass;
+  // "VGA controller"
+  const char* prog_if;
+};
+
+/**
+ * The names of PCISubsystem, PCIDevice and PCIVendor are accessors: subsystem_name() etc. return a std::string, so
+ * that comparing them with a literal compares the text. *_c_str() is the name in the database without a copy.
+ */
+class PCISubsystem {
+ public:
+  PCISubsystem(uint16_t s_vendor_id, uint16_t s_device_id, const char* s_name)
+      : subvendor_id(s_vendor_id), subdevice_id(s_device_id), _name(s_name) {}
+
+  std::string subsystem_name() const { return _name; }
+  const char* subsystem_name_c_str() const { return _name; }
+
+  const uint16_t subvendor_id;
+  const uint16_t subdevice_id;
 
-  const std::string device_id{};
-  const std::string device_name{};
-  std::map<std::string, std::string> subsystems{};
+ private:
+  const char* _name;
 };
 
-struct PCIVendor {
-  PCIVendor(std::string v_id, std::string v_name)
-      : vendor_id(std::move(v_id)), vendor_name(std::move(v_name)) {}
+/**
+ * Lightweight view on a device of the PCI ID database. Only valid as long as the mapper it was taken from lives.
+ */
+class PCIDevice {
+ public:
+  PCIDevice(uint16_t d_id, const char* d_name, const PCISubsystemRecord* subsystems, size_t num_subsystems,
+            const pci::Names* names)
+      : device_id(d_id), _name(d_name), _subsystems(subsystems), _num_subsystems(num_subsystems), _names(names) {}
+
+  bool valid() const { return _names != nullptr; }
 
-  const PCIDevice& operator[](const std::string& device_id) const {
-    std::string d_id =
-        utils::starts_with(device_id, "0x") ? std::string(device_id.begin() + 2, device_id.end()) : device_id;
-    if (devices.find(d_id) == devices.end()) {
-      return _invalid_device;
+  size_t num_subsystems() const { return _num_subsystems; }
+
+  PCISubsystem subsystem_at(size_t index) const {
+    const PCISubsystemRecord& record = _subsystems[index];
+    return {record.subvendor_id, record.subdevice_id, (*_names)[record.name]};
+  }
+
+  /**
+   * Name of the subsystem (subvendor_id, subdevice_id) of this device, nullptr if it is unknown.
+   */
+  const char* subsystem_name(uint16_t subvendor_id, uint16_t subdevice_id) const {
+    if (_num_subsystems == 0) {
+      return nullptr;
     }
-    return devices.at(d_id);
+    const uint32_t key = static_cast<uint32_t>(subvendor_id) << 16 | subdevice_id;
+    const PCISubsystemRecord* last = _subsystems + _num_subsystems;
+    const PCISubsystemRecord* it =
+        std::lower_bound(_subsystems, last, key, [](const PCISubsystemRecord& record, uint32_t k) {
+          return (static_cast<uint32_t>(record.subvendor_id) << 16 | record.subdevice_id) < k;
+        });
+    if (it == last || it->subvendor_id != subvendor_id || it->subdevice_id != subdevice_id) {
+      return nullptr;
+    }
+    return (*_names)[it->name];
   }
 
-  const std::string vendor_id{};
-  const std::string vendor_name{};
-  std::map<std::string, PCIDevice> devices{};
+  /**
+   * Subsystem by (subvendor, subdevice) id. Returns a subsystem named "invalid" if the pair is unknown.
+   */
+  PCISubsystem subsystem_from_id(uint16_t subvendor_id, uint16_t subdevice_id) const {
+    const char* name = subsystem_name(subvendor_id, subdevice_id);
+    return {subvendor_id, subdevice_id, name == nullptr ? "invalid" : name};
+  }
+
+  std::string device_name() const { return _name; }
+  const char* device_name_c_str() const { return _name; }
+
+  const uint16_t device_id;
 
  private:
-  PCIDevice _invalid_device{"0000", "invalid"};
+  const char* _name;
+  const PCISubsystemRecord* _subsystems;
+  size_t _num_subsystems;
+  const pci::Names* _names;
 };
 
-class PCIMapper {
+/**
+ * Lightweight view on a vendor of the PCI ID database. Only valid as long as the mapper it was taken from lives.
+ */
+class PCIVendor {
  public:
-  explicit PCIMapper(const std::string& pci_ids_file) {
-    std::ifstream f_pciid(pci_ids_file);
-    if (!f_pciid) {
-      throw std::runtime_error("ERROR: Could not open file '" + pci_ids_file + "'.\n");
+  PCIVendor(uint16_t v_id, const char* v_name, const PCIDeviceRecord* devices, size_t num_devices,
+            const PCISubsystemRecord* subsystems, const pci::Names* names)
+      : vendor_id(v_id),
+        _name(v_name),
+        _devices(devices),
+        _num_devices(num_devices),
+        _subsystems(subsystems),
+        _names(names) {}
+
+  bool valid() const { return _names != nullptr; }
+
+  size_t num_devices() const { return _num_devices; }
+
+  PCIDevice device_at(size_t index) const { return make_device(&_devices[index]); }
+
+  PCIDevice device_from_id(uint16_t device_id) const {
+    return make_device(pci::find_record(_devices, _num_devices, device_id));
+  }
+
+  /**
+   * Device by hex id ("2484" or "0x2484"). Returns an invalid device named "invalid" if the id is unknown.
+   */
+  PCIDevice device_from_id(const char* device_id, size_t size) const {
+    int32_t id = pci::parse_id(device_id, size);
+    return id < 0 ? make_device(nullptr) : device_from_id(static_cast<uint16_t>(id));
+  }
+
+  PCIDevice operator[](const std::string& device_id) const {
+    return device_from_id(device_id.data(), device_id.size());
+  }
+
+  // string literals are parsed in place, without constructing a std::string
+  template <size_t N>
+  PCIDevice operator[](const char (&device_id)[N]) const {
+    return device_from_id(device_id, N - 1);
+  }
+
+  PCIDevice operator[](uint16_t device_id) const { return device_from_id(device_id); }
+
+  std::string vendor_name() const { return _name; }
+  const char* vendor_name_c_str() const { return _name; }
+
+  const uint16_t vendor_id;
+
+ private:
+  PCIDevice make_device(const PCIDeviceRecord* record) const {
+    if (record == nullptr) {
+      return {0, "invalid", nullptr, 0, nullptr};
     }
-    PCIVendor* current_vendor = nullptr;
-    PCIDevice* current_device = nullptr;
-    while (true) {
-      std::string line;
-      if (!std::getline(f_pciid, line)) {
-        break;
+    return {record->id, (*_names)[record->name], _subsystems + record->first_subsystem, record->num_subsystems,
+            _names};
+  }
+
+  const char* _name;
+  const PCIDeviceRecord* _devices;
+  size_t _num_devices;
+  const PCISubsystemRecord* _subsystems;
+  const pci::Names* _names;
+};
+
+namespace pci {
+
+/**
+ * Owning storage of the tables, filled by parsing pci.ids text.
+ */
+struct Tables {
+  /**
+   * Append name to the arena and return its offset.
+   */
+  uint32_t add_name(const char* begin, const char* end) {
+    auto offset = static_cast<uint32_t>(names.size());
+    names.append(begin, end);
+    names.push_back('\0');
+    return offset;
+  }
+
+  /**
+   * Parse the pci.ids text in [begin, end). Lines are "vvvv  vendor", "\tdddd  device" and
+   * "\t\tssss ssss  subsystem", followed by the class section (see parse_classes()). Malformed lines are skipped.
+   */
+  void parse(const char* begin, const char* end) {
+    names.reserve(static_cast<size_t>(end - begin) / 2);
+    bool in_vendor = false;
+    bool in_device = false;
+    const char* line = begin;
+    while (line < end) {
+      const char* line_end = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+      if (line_end == nullptr) {
+        line_end = end;
       }
-      if (utils::starts_with(line, "#") || utils::starts_with(line, "\n") || line.empty()) {
-        // empty line or comment
+      const char* next = line_end + 1;
+      while (line_end > line && (line_end[-1] == '\r' || line_end[-1] == ' ')) {
+        line_end--;
+      }
+      if (line == line_end || *line == '#') {
+        line = next;
         continue;
       }
-      if (utils::starts_with(line, "\t\t")) {
-        // subsystem entry
-        utils::strip(line);
-        auto split_line = utils::split(line, "  ");
-        if (split_line.size() != 2 || current_device == nullptr) {
-          // parse error
-          continue;
-        }
-        current_device->subsystems.insert({split_line[0], split_line[1]});
-      } else if (utils::starts_with(line, "\t")) {
-        // device
-        utils::strip(line);
-        auto split_line = utils::split(line, "  ");
-        if (split_line.size() != 2 || current_vendor == nullptr) {
-          // parse error
-          continue;
+      if (line[0] == 'C' && line_end - line > 1 && line[1] == ' ') {
+        parse_classes(line, end);
+        break;
+      }
+      int depth = 0;
+      while (depth < 2 && line + depth < line_end && line[depth] == '\t') {
+        depth++;
+      }
+      const char* p = line + depth;
+      int32_t id = parse_prefix_id(p, line_end);
+      int32_t subdevice_id = 0;
+      if (id >= 0 && depth == 2) {
+        if (p < line_end && *p == ' ') {
+          ++p;
         }
-        current_vendor->devices.insert({split_line[0], {split_line[0], split_line[1]}});
-        current_device = &current_vendor->devices.at(split_line[0]);
-      } else {
-        // vendor
-        utils::strip(line);
-        auto split_line = utils::split(line, "  ");
-        if (split_line.size() != 2) {
-          // parse error
-          continue;
+        subdevice_id = parse_prefix_id(p, line_end);
+      }
+      if (id < 0 || subdevice_id < 0 || p == line_end || *p != ' ') {
+        // parse error
+        line = next;
+        continue;
+      }
+      while (p < line_end && (*p == ' ' || *p == '\t')) {
+        ++p;
+      }
+      if (depth == 0) {
+        vendors.push_back({static_cast<uint16_t>(id), add_name(p, line_end),
+                            static_cast<uint32_t>(devices.size()), 0});
+        in_vendor = true;
+        in_device = false;
+      } else if (depth == 1 && in_vendor) {
+        devices.push_back({static_cast<uint16_t>(id), add_name(p, line_end),
+                            static_cast<uint32_t>(subsystems.size()), 0});
+        vendors.back().num_devices++;
+        in_device = true;
+      } else if (depth == 2 && in_device) {
+        subsystems.push_back({static_cast<uint16_t>(id), static_cast<uint16_t>(subdevice_id), add_name(p, line_end)});
+        devices.back().num_subsystems++;
+      }
+      line = next;
+    }
+
+    // pci.ids is sorted, but lookups must not depend on that: sort every level. Ranges are referenced by index, so
+    // sorting one level does not invalidate the ranges of the level below.
+    for (const auto& device : devices) {
+      auto first = subsystems.begin() + device.first_subsystem;
+      std::sort(first, first + device.num_subsystems, [](const PCISubsystemRecord& a, const PCISubsystemRecord& b) {
+        return a.subvendor_id != b.subvendor_id ? a.subvendor_id < b.subvendor_id : a.subdevice_id < b.subdevice_id;
+      });
+    }
+    for (const auto& vendor : vendors) {
+      auto first = devices.begin() + vendor.first_device;
+      std::sort(first, first + vendor.num_devices,
+                [](const PCIDeviceRecord& a, const PCIDeviceRecord& b) { return a.id < b.id; });
+    }
+    std::sort(vendors.begin(), vendors.end(),
+              [](const PCIVendorRecord& a, const PCIVendorRecord& b) { return a.id < b.id; });
+    vendors.shrink_to_fit();
+    devices.shrink_to_fit();
+    subsystems.shrink_to_fit();
+    names.shrink_to_fit();
+  }
+
+  /**
+   * Parse the class section starting at begin: "C cc  class", "\tss  subclass" and "\t\tpp  programming interface".
+   * Ends at the first line that is neither (usb.ids has further sections after the classes).
+   */
+  void parse_classes(const char* begin, const char* end) {
+    uint32_t class_code = 0;
+    uint32_t subclass_code = 0;
+    bool in_class = false;
+    bool in_subclass = false;
+    const char* line = begin;
+    while (line < end) {
+      const char* line_end = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+      if (line_end == nullptr) {
+        line_end = end;
+      }
+      const char* next = line_end + 1;
+      while (line_end > line && (line_end[-1] == '\r' || line_end[-1] == ' ')) {
+        line_end--;
+      }
+      if (line == line_end || *line == '#') {
+        line = next;
+        continue;
+      }
+      int depth = 0;
+      while (depth < 2 && line + depth < line_end && line[depth] == '\t') {
+        depth++;
+      }
+      const char* p = line + depth;
+      if (depth == 0) {
+        if (line_end - line < 2 || line[0] != 'C' || line[1] != ' ') {
+          break;
         }
-        _vendors.insert({split_line[0], {split_line[0], split_line[1]}});
-        current_vendor = &_vendors.at(split_line[0]);
+        p += 2;
       }
+      int32_t id = (line_end - p > 2 && p[2] == ' ') ? pci::parse_id(p, 2) : -1;
+      if (id < 0) {
+        line = next;
+        continue;
+      }
+      p += 2;
+      while (p < line_end && (*p == ' ' || *p == '\t')) {
+        ++p;
+      }
+      const auto code = static_cast<uint32_t>(id);
+      if (depth == 0) {
+        class_code = code;
+        in_class = true;
+        in_subclass = false;
+        classes.push_back({class_key(0, class_code << 16), add_name(p, line_end)});
+      } else if (depth == 1 && in_class) {
+        subclass_code = code;
+        in_subclass = true;
+        classes.push_back({class_key(1, class_code << 16 | subclass_code << 8), add_name(p, line_end)});
+      } else if (depth == 2 && in_subclass) {
+        classes.push_back({class_key(2, class_code << 16 | subclass_code << 8 | code), add_name(p, line_end)});
+      }
+      line = next;
     }
+    std::sort(classes.begin(), classes.end(),
+              [](const PCIClassRecord& a, const PCIClassRecord& b) { return a.key < b.key; });
+    classes.shrink_to_fit();
   }
 
-  ~PCIMapper() = default;
+  /**
+   * Parse exactly 4 hex digits at p and advance p. Returns -1 on error.
+   */
+  static int32_t parse_prefix_id(const char*& p, const char* end) {
+    if (end - p < 4) {
+      return -1;
+    }
+    int32_t id = pci::parse_id(p, 4);
+    if (id >= 0) {
+      p += 4;
+    }
+    return id;
+  }
+
+  std::vector<PCIVendorRecord> vendors;
+  std::vector<PCIDeviceRecord> devices;
+  std::vector<PCISubsystemRecord> subsystems;
+  std::vector<PCIClassRecord> classes;
+  std::string names;
+};
 
-  const PCIVendor& vendor_from_id(const std::string& vendor_id) const {
-    std::string v_id =
-        utils::starts_with(vendor_id, "0x") ? std::string(vendor_id.begin() + 2, vendor_id.end()) : vendor_id;
-    if (_vendors.find(v_id) == _vendors.end()) {
-      return _invalid_vendor;
+/**
+ * A vendor of a lazily parsed pci.ids: its block of lines in the text is only parsed on first lookup.
+ */
+struct LazyVendor {
+  uint16_t id{0};
+  const char* begin{nullptr};
+  const char* end{nullptr};
+  std::atomic<bool> parsed{false};
+  Tables tables;
+  Names names{nullptr, nullptr};
+};
+
+}  // namespace pci
+
+enum class PCIParseMode {
+  // parse the whole file on construction
+  Eager,
+  // only locate the vendors on construction, parse the devices of a vendor when it is first looked up
+  Lazy
+};
+
+/**
+ * Header of the binary ID index: the tables of a parsed ids file dumped as they are in memory, so that they can be
+ * mmapped and used in place. The index is bound to the ids file it was built from by the size and mtime of that file.
+ */
+struct IDIndexHeader {
+  char magic[8];
+  uint32_t version;
+  // sizes of the record types and 0x01020304 as written by this machine: guards against foreign index files
+  uint32_t record_sizes;
+  uint32_t byte_order;
+  uint32_t reserved;
+  uint64_t source_size;
+  int64_t source_mtime;
+  uint64_t num_vendors;
+  uint64_t num_devices;
+  uint64_t num_subsystems;
+  uint64_t num_classes;
+  uint64_t names_size;
+  uint64_t vendors_offset;
+  uint64_t devices_offset;
+  uint64_t subsystems_offset;
+  uint64_t classes_offset;
+  uint64_t names_offset;
+};
+
+/**
+ * Parser and lookup engine for the tab indented id databases of the hwdata project (pci.ids, usb.ids):
+ *   vvvv  vendor
+ *   \tdddd  device
+ *   \t\tssss ssss  subsystem
+ * followed by sections that are not part of the vendor tables (starting with the class section "C xx  class").
+ * PCIMapper and USBMapper are this engine for the respective file.
+ */
+class IDMapper {
+ public:
+  static const uint32_t index_version = 2;
+
+  // empty mapper: every lookup returns the invalid vendor/device
+  IDMapper() = default;
+
+  /**
+   * Parse the ids file at ids_file. Throws std::runtime_error if the file cannot be read.
+   */
+  explicit IDMapper(const std::string& ids_file) { parse_file(ids_file); }
+
+  /**
+   * Use the binary index at index_file if it was built from the current ids_file (same size and mtime): the index
+   * is mmapped and used in place, nothing is parsed or copied. Otherwise ids_file is parsed and the index is
+   * (re)written, so that the next process starts from the index. Failing to write the index (e.g. read-only
+   * filesystem) is not an error. Throws std::runtime_error if ids_file cannot be read and there is no usable index.
+   */
+  IDMapper(const std::string& ids_file, const std::string& index_file) {
+    if (!index_file.empty() && map_index(ids_file, index_file)) {
+      return;
+    }
+    parse_file(ids_file);
+    if (!index_file.empty()) {
+      write_index(ids_file, index_file);
     }
-    return _vendors.at(v_id);
   }
 
-  const PCIVendor& operator[](const std::string& vendor_id) const { return vendor_from_id(vendor_id); }
+  /**
+   * Like IDMapper(ids_file) for PCIParseMode::Eager. In lazy mode the file is mmapped and construction is a
+   * single scan for vendor lines; the devices and subsystems of a vendor are parsed on its first lookup (thread-safe)
+   * and kept. Worthwhile if only a few vendors are resolved, which is the common case.
+   * Throws std::runtime_error if the file cannot be read.
+   */
+  IDMapper(const std::string& ids_file, PCIParseMode mode) {
+    if (mode == PCIParseMode::Lazy) {
+      scan_file(ids_file);
+    } else {
+      parse_file(ids_file);
+    }
+  }
+
+  /**
+   * Use tables that live as long as the process, e.g. compiled in with HWINFO_EMBED_PCI_IDS. The name field of the
+   * records is an index into names. Nothing is copied.
+   */
+  IDMapper(const PCIVendorRecord* vendors, size_t num_vendors, const PCIDeviceRecord* devices, size_t num_devices,
+            const PCISubsystemRecord* subsystems, size_t num_subsystems, const PCIClassRecord* classes,
+            size_t num_classes, const char* const* names)
+      : _vendor_table(vendors),
+        _num_vendors(num_vendors),
+        _device_table(devices),
+        _num_devices(num_devices),
+        _subsystem_table(subsystems),
+        _num_subsystems(num_subsystems),
+        _class_table(classes),
+        _num_classes(num_classes),
+        _names_lookup{nullptr, names} {}
+
+  // views handed out point into this object
+  IDMapper(const IDMapper&) = delete;
+  IDMapper& operator=(const IDMapper&) = delete;
+
+  ~IDMapper() {
+#if defined(HWINFO_UNIX) || defined(HWINFO_APPLE)
+    if (_mapping != nullptr) {
+      munmap(_mapping, _mapping_size);
+    }
+#endif
+  }
+
+  // true if the tables are used in place from an mmapped index file
+  bool from_index() const { return _mapping != nullptr && !_lazy_vendors; }
+
+  // true if constructed with PCIParseMode::Lazy
+  bool lazy() const { return static_cast<bool>(_lazy_vendors); }
+
+  size_t num_vendors() const { return _num_vendors; }
+
+  PCIVendor vendor_at(size_t index) const {
+    return _lazy_vendors ? make_lazy_vendor(&_lazy_vendors[index]) : make_vendor(&_vendor_table[index]);
+  }
+
+  PCIVendor vendor_from_id(uint16_t vendor_id) const {
+    if (_lazy_vendors) {
+      return make_lazy_vendor(pci::find_record(_lazy_vendors.get(), _num_vendors, vendor_id));
+    }
+    return make_vendor(pci::find_record(_vendor_table, _num_vendors, vendor_id));
+  }
+
+  /**
+   * Vendor by hex id ("10de" or "0x10de"). Returns an invalid vendor named "invalid" if the id is unknown.
+   */
+  PCIVendor vendor_from_id(const char* vendor_id, size_t size) const {
+    int32_t id = pci::parse_id(vendor_id, size);
+    return id < 0 ? make_vendor(nullptr) : vendor_from_id(static_cast<uint16_t>(id));
+  }
+
+  PCIVendor vendor_from_id(const std::string& vendor_id) const {
+    return vendor_from_id(vendor_id.data(), vendor_id.size());
+  }
+
+  PCIVendor operator[](const std::string& vendor_id) const { return vendor_from_id(vendor_id); }
+
+  // string literals are parsed in place, without constructing a std::string
+  template <size_t N>
+  PCIVendor operator[](const char (&vendor_id)[N]) const {
+    return vendor_from_id(vendor_id, N - 1);
+  }
+
+  PCIVendor operator[](uint16_t vendor_id) const { return vendor_from_id(vendor_id); }
+
+  /**
+   * Names of the vendor, device and subsystem identified by ids. A name is nullptr if the id is not in the database.
+   * Nothing is allocated.
+   */
+  PCINames resolve(const PCIIds& ids) const {
+    PCINames names{nullptr, nullptr, nullptr};
+    resolve(&ids, 1, &names);
+    return names;
+  }
+
+  /**
+   * resolve() for count id tuples, written to names[0, count). Consecutive tuples with the same vendor and device
+   * (the common case in sorted inventories) reuse the previous lookup.
+   */
+  void resolve(const PCIIds* ids, size_t count, PCINames* names) const {
+    size_t i = 0;
+    while (i < count) {
+      const PCIVendor vendor = vendor_from_id(ids[i].vendor_id);
+      size_t vendor_end = i + 1;
+      while (vendor_end < count && ids[vendor_end].vendor_id == ids[i].vendor_id) {
+        vendor_end++;
+      }
+      while (i < vendor_end) {
+        const PCIDevice device = vendor.device_from_id(ids[i].device_id);
+        do {
+          names[i] = {vendor.valid() ? vendor.vendor_name_c_str() : nullptr,
+                      device.valid() ? device.device_name_c_str() : nullptr,
+                      device.subsystem_name(ids[i].subvendor_id, ids[i].subdevice_id)};
+        } while (++i < vendor_end && ids[i].device_id == ids[i - 1].device_id);
+      }
+    }
+  }
+
+  size_t num_classes() const { return _num_classes; }
+
+  /**
+   * Names of base class, subclass and programming interface of class_code (0xCCSSPP, as in the class attribute of a
+   * PCI function). Each name is nullptr if that level is not in the database.
+   */
+  PCIClassNames resolve_class(uint32_t class_code) const {
+    return {class_name(pci::class_key(0, class_code & 0xff0000)), class_name(pci::class_key(1, class_code & 0xffff00)),
+            class_name(pci::class_key(2, class_code))};
+  }
+
+  /**
+   * Write the tables as binary index for ids_file to index_file (atomically, via a temporary file).
+   * Returns false if the index could not be written.
+   */
+  bool write_index(const std::string& ids_file, const std::string& index_file) const {
+    if (_names_lookup.table != nullptr || _lazy_vendors) {
+      // names are not in an arena / tables are incomplete
+      return false;
+    }
+    uint64_t source_size = 0;
+    int64_t source_mtime = 0;
+    if (!stat_file(ids_file, source_size, source_mtime)) {
+      return false;
+    }
+    IDIndexHeader header{};
+    std::memcpy(header.magic, "HWIPCIX", 8);
+    header.version = index_version;
+    header.record_sizes = record_sizes();
+    header.byte_order = 0x01020304;
+    header.source_size = source_size;
+    header.source_mtime = source_mtime;
+    header.num_vendors = _num_vendors;
+    header.num_devices = _num_devices;
+    header.num_subsystems = _num_subsystems;
+    header.num_classes = _num_classes;
+    header.names_size = _names_size;
+    header.vendors_offset = align(sizeof(IDIndexHeader));
+    header.devices_offset = align(header.vendors_offset + _num_vendors * sizeof(PCIVendorRecord));
+    header.subsystems_offset = align(header.devices_offset + _num_devices * sizeof(PCIDeviceRecord));
+    header.classes_offset = align(header.subsystems_offset + _num_subsystems * sizeof(PCISubsystemRecord));
+    header.names_offset = align(header.classes_offset + _num_classes * sizeof(PCIClassRecord));
+
+    make_directories(index_file.substr(0, index_file.rfind('/') + 1));
+    // unique among the processes and threads that write the same index
+    static std::atomic<unsigned> tmp_counter(0);
+    const std::string tmp_file(index_file + ".tmp" + std::to_string(current_process_id()) + '.' +
+                               std::to_string(tmp_counter.fetch_add(1)));
+    {
+      std::ofstream out(tmp_file, std::ios::binary | std::ios::trunc);
+      if (!out) {
+        return false;
+      }
+      auto write_at = [&out](uint64_t offset, const void* data, size_t size) {
+        static const char zeros[8] = {0};
+        auto position = static_cast<uint64_t>(out.tellp());
+        out.write(zeros, static_cast<std::streamsize>(offset - position));
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+      };
+      write_at(0, &header, sizeof(header));
+      write_at(header.vendors_offset, _vendor_table, _num_vendors * sizeof(PCIVendorRecord));
+      write_at(header.devices_offset, _device_table, _num_devices * sizeof(PCIDeviceRecord));
+      write_at(header.subsystems_offset, _subsystem_table, _num_subsystems * sizeof(PCISubsystemRecord));
+      write_at(header.classes_offset, _class_table, _num_classes * sizeof(PCIClassRecord));
+      write_at(header.names_offset, _names_lookup.arena, _names_size);
+      if (!out.flush()) {
+        std::remove(tmp_file.c_str());
+        return false;
+      }
+    }
+    if (std::rename(tmp_file.c_str(), index_file.c_str()) != 0) {
+      std::remove(tmp_file.c_str());
+      return false;
+    }
+    return true;
+  }
 
  private:
-  std::map<std::string, PCIVendor> _vendors{};
-  PCIVendor _invalid_vendor{"0000", "invalid"};
-};
+  PCIVendor make_vendor(const PCIVendorRecord* record) const {
+    if (record == nullptr) {
+      return {0, "invalid", nullptr, 0, nullptr, nullptr};
+    }
+    return {record->id,          _names_lookup[record->name], _device_table + record->first_device,
+            record->num_devices, _subsystem_table,            &_names_lookup};
+  }
 
-struct PCI {
-  static PCIMapper getMapper() {
-    const auto getenv = [](const char* name) -> std::string {
-
-#ifdef _MSC_VER
-      char* value;
-      size_t size;
-      _dupenv_s(&value, &size, name);
-      std::string ret(value);
-      free(value);
+  /**
+   * Parse the block of vendor on first use. The flag is checked without the lock first, so resolved vendors cost no
+   * locking.
+   */
+  PCIVendor make_lazy_vendor(pci::LazyVendor* vendor) const {
+    if (vendor == nullptr) {
+      return make_vendor(nullptr);
+    }
+    if (!vendor->parsed.load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> lock(_lazy_mutex);
+      if (!vendor->parsed.load(std::memory_order_relaxed)) {
+        vendor->tables.parse(vendor->begin, vendor->end);
+        vendor->names.arena = vendor->tables.names.data();
+        vendor->parsed.store(true, std::memory_order_release);
+      }
+    }
+    const pci::Tables& tables = vendor->tables;
+    if (tables.vendors.empty()) {
+      return make_vendor(nullptr);
+    }
+    const PCIVendorRecord& record = tables.vendors[0];
+    return {record.id,          vendor->names[record.name], tables.devices.data(),
+            record.num_devices, tables.subsystems.data(),   &vendor->names};
+  }
+
+  const char* class_name(uint32_t key) const {
+    const PCIClassRecord* last = _class_table + _num_classes;
+    const PCIClassRecord* it = std::lower_bound(
+        _class_table, last, key, [](const PCIClassRecord& record, uint32_t k) { return record.key < k; });
+    return (it != last && it->key == key) ? _names_lookup[it->name] : nullptr;
+  }
+
+  static long current_process_id() {
+#if defined(HWINFO_UNIX) || defined(HWINFO_APPLE)
+    return static_cast<long>(getpid());
+#elif defined(HWINFO_WINDOWS)
+    return static_cast<long>(_getpid());
 #else
-      std::string ret(std::getenv(name));
+    return 0;
+#endif
+  }
+
+  /**
+   * Create directory (ending with '/') and its missing ancestors. Ancestors are private (0700, like the XDG base
+   * directories), the directory itself is 0755. Failures show up when the index is written.
+   */
+  static void make_directories(const std::string& directory) {
+#if defined(HWINFO_UNIX) || defined(HWINFO_APPLE)
+    for (auto slash = directory.find('/', 1); slash != std::string::npos; slash = directory.find('/', slash + 1)) {
+      const std::string path = directory.substr(0, slash);
+      mkdir(path.c_str(), slash + 1 == directory.size() ? 0755 : 0700);
+    }
+#else
+    (void)directory;
+#endif
+  }
+
+  static uint64_t align(uint64_t offset) { return (offset + 7) & ~static_cast<uint64_t>(7); }
+
+  static uint32_t record_sizes() {
+    return static_cast<uint32_t>(sizeof(PCIVendorRecord) << 24 | sizeof(PCIDeviceRecord) << 16 |
+                                 sizeof(PCISubsystemRecord) << 8 | sizeof(PCIClassRecord));
+  }
+
+  static bool stat_file(const std::string& path, uint64_t& size, int64_t& mtime) {
+#if defined(HWINFO_UNIX) || defined(HWINFO_APPLE)
+    struct stat st {};
+    if (stat(path.c_str(), &st) != 0) {
+      return false;
+    }
+    size = static_cast<uint64_t>(st.st_size);
+    mtime = static_cast<int64_t>(st.st_mtime);
+    return true;
+#else
+    (void)path;
+    (void)size;
+    (void)mtime;
+    return false;
+#endif
+  }
+
+  /**
+   * true if [offset, offset + count * record_size) is an aligned range within a file of size bytes (without overflow).
+   */
+  static bool valid_range(uint64_t offset, uint64_t count, uint64_t record_size, uint64_t size) {
+    return offset % 8 == 0 && offset <= size && count <= (size - offset) / record_size;
+  }
+
+  /**
+   * Check every table range of header against the size of the index and every record against the other tables and
+   * the name arena, so that a truncated or corrupted index is rejected instead of read out of bounds.
+   */
+  static bool valid_index(const char* base, uint64_t size, const IDIndexHeader& header) {
+    if (!valid_range(header.vendors_offset, header.num_vendors, sizeof(PCIVendorRecord), size) ||
+        !valid_range(header.devices_offset, header.num_devices, sizeof(PCIDeviceRecord), size) ||
+        !valid_range(header.subsystems_offset, header.num_subsystems, sizeof(PCISubsystemRecord), size) ||
+        !valid_range(header.classes_offset, header.num_classes, sizeof(PCIClassRecord), size) ||
+        header.names_offset > size || header.names_size == 0 || header.names_size > size - header.names_offset ||
+        base[header.names_offset + header.names_size - 1] != '\0') {
+      return false;
+    }
+    // the arena ends with a NUL, so every name offset within it is a terminated string
+    const uint64_t names_size = header.names_size;
+    const auto* vendors = reinterpret_cast<const PCIVendorRecord*>(base + header.vendors_offset);
+    for (uint64_t i = 0; i < header.num_vendors; ++i) {
+      if (vendors[i].name >= names_size ||
+          static_cast<uint64_t>(vendors[i].first_device) + vendors[i].num_devices > header.num_devices) {
+        return false;
+      }
+    }
+    const auto* devices = reinterpret_cast<const PCIDeviceRecord*>(base + header.devices_offset);
+    for (uint64_t i = 0; i < header.num_devices; ++i) {
+      if (devices[i].name >= names_size ||
+          static_cast<uint64_t>(devices[i].first_subsystem) + devices[i].num_subsystems > header.num_subsystems) {
+        return false;
+      }
+    }
+    const auto* subsystems = reinterpret_cast<const PCISubsystemRecord*>(base + header.subsystems_offset);
+    for (uint64_t i = 0; i < header.num_subsystems; ++i) {
+      if (subsystems[i].name >= names_size) {
+        return false;
+      }
+    }
+    const auto* classes = reinterpret_cast<const PCIClassRecord*>(base + header.classes_offset);
+    for (uint64_t i = 0; i < header.num_classes; ++i) {
+      if (classes[i].name >= names_size) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * mmap index_file and point the tables into it, if it is a valid index for the current ids_file.
+   */
+  bool map_index(const std::string& ids_file, const std::string& index_file) {
+#if defined(HWINFO_UNIX) || defined(HWINFO_APPLE)
+    uint64_t source_size = 0;
+    int64_t source_mtime = 0;
+    if (!stat_file(ids_file, source_size, source_mtime)) {
+      return false;
+    }
+    int fd = open(index_file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < sizeof(IDIndexHeader)) {
+      close(fd);
+      return false;
+    }
+    auto size = static_cast<size_t>(st.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+      return false;
+    }
+    const auto* base = static_cast<const char*>(mapping);
+    IDIndexHeader header{};
+    std::memcpy(&header, base, sizeof(header));
+    const bool valid = std::memcmp(header.magic, "HWIPCIX", 8) == 0 && header.version == index_version &&
+                       header.record_sizes == record_sizes() && header.byte_order == 0x01020304 &&
+                       header.source_size == source_size && header.source_mtime == source_mtime &&
+                       valid_index(base, size, header);
+    if (!valid) {
+      munmap(mapping, size);
+      return false;
+    }
+    _mapping = mapping;
+    _mapping_size = size;
+    _vendor_table = reinterpret_cast<const PCIVendorRecord*>(base + header.vendors_offset);
+    _num_vendors = static_cast<size_t>(header.num_vendors);
+    _device_table = reinterpret_cast<const PCIDeviceRecord*>(base + header.devices_offset);
+    _num_devices = static_cast<size_t>(header.num_devices);
+    _subsystem_table = reinterpret_cast<const PCISubsystemRecord*>(base + header.subsystems_offset);
+    _num_subsystems = static_cast<size_t>(header.num_subsystems);
+    _class_table = reinterpret_cast<const PCIClassRecord*>(base + header.classes_offset);
+    _num_classes = static_cast<size_t>(header.num_classes);
+    _names_lookup.arena = base + header.names_offset;
+    _names_size = static_cast<size_t>(header.names_size);
+    return true;
+#else
+    (void)ids_file;
+    (void)index_file;
+    return false;
+#endif
+  }
+
+  /**
+   * Make the text of ids_file available as [_text, _text + _text_size): mmapped where possible, read otherwise.
+   */
+  void load_text(const std::string& ids_file) {
+#if defined(HWINFO_UNIX) || defined(HWINFO_APPLE)
+    int fd = open(ids_file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      throw std::runtime_error("ERROR: Could not open file '" + ids_file + "'.\n");
+    }
+    struct stat st {};
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping != MAP_FAILED) {
+        close(fd);
+        _mapping = mapping;
+        _mapping_size = static_cast<size_t>(st.st_size);
+        _text = static_cast<const char*>(mapping);
+        _text_size = _mapping_size;
+        return;
+      }
+    }
+    close(fd);
 #endif
-      return ret;
+    std::ifstream f_pciid(ids_file, std::ios::binary);
+    if (!f_pciid) {
+      throw std::runtime_error("ERROR: Could not open file '" + ids_file + "'.\n");
+    }
+    _text_storage.assign(std::istreambuf_iterator<char>(f_pciid), std::istreambuf_iterator<char>());
+    _text = _text_storage.data();
+    _text_size = _text_storage.size();
+  }
+
+  /**
+   * Lazy mode: find the vendor lines (no leading tab) and the extent of their blocks. Everything else is skipped with
+   * memchr.
+   */
+  void scan_file(const std::string& ids_file) {
+    load_text(ids_file);
+    struct Block {
+      uint16_t id;
+      const char* begin;
+      const char* end;
     };
+    std::vector<Block> blocks;
+    blocks.reserve(4096);
+    const char* end = _text + _text_size;
+    const char* line = _text;
+    while (line < end) {
+      const char* line_end = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+      const char* next = line_end == nullptr ? end : line_end + 1;
+      if (*line == '\t' || *line == '#' || *line == '\n' || *line == '\r') {
+        line = next;
+        continue;
+      }
+      if (line[0] == 'C' && next - line > 1 && line[1] == ' ') {
+        // the class section is small: parse it right away
+        _tables.parse_classes(line, end);
+        _class_table = _tables.classes.data();
+        _num_classes = _tables.classes.size();
+        _names_lookup.arena = _tables.names.data();
+        end = line;
+        break;
+      }
+      int32_t id = next - line > 4 ? pci::parse_id(line, 4) : -1;
+      if (id >= 0 && (line[4] == ' ' || line[4] == '\t')) {
+        if (!blocks.empty()) {
+          blocks.back().end = line;
+        }
+        blocks.push_back({static_cast<uint16_t>(id), line, end});
+      }
+      line = next;
+    }
+    if (!blocks.empty()) {
+      blocks.back().end = end;
+    }
+    std::sort(blocks.begin(), blocks.end(), [](const Block& a, const Block& b) { return a.id < b.id; });
+    _num_vendors = blocks.size();
+    _lazy_vendors.reset(new pci::LazyVendor[blocks.size()]);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+      _lazy_vendors[i].id = blocks[i].id;
+      _lazy_vendors[i].begin = blocks[i].begin;
+      _lazy_vendors[i].end = blocks[i].end;
+    }
+  }
+
+  void parse_file(const std::string& ids_file) {
+    std::ifstream f_pciid(ids_file, std::ios::binary);
+    if (!f_pciid) {
+      throw std::runtime_error("ERROR: Could not open file '" + ids_file + "'.\n");
+    }
+    f_pciid.seekg(0, std::ios::end);
+    std::string text(static_cast<size_t>(std::max<std::streamoff>(f_pciid.tellg(), 0)), '\0');
+    f_pciid.seekg(0, std::ios::beg);
+    f_pciid.read(&text[0], static_cast<std::streamsize>(text.size()));
+    text.resize(static_cast<size_t>(f_pciid.gcount()));
+    _tables.parse(text.data(), text.data() + text.size());
+    _vendor_table = _tables.vendors.data();
+    _num_vendors = _tables.vendors.size();
+    _device_table = _tables.devices.data();
+    _num_devices = _tables.devices.size();
+    _subsystem_table = _tables.subsystems.data();
+    _num_subsystems = _tables.subsystems.size();
+    _class_table = _tables.classes.data();
+    _num_classes = _tables.classes.size();
+    _names_lookup.arena = _tables.names.data();
+    _names_size = _tables.names.size();
+  }
+
+  // the tables, either pointing into the vectors below (parsed) or into the mmapped index
+  const PCIVendorRecord* _vendor_table{nullptr};
+  size_t _num_vendors{0};
+  const PCIDeviceRecord* _device_table{nullptr};
+  size_t _num_devices{0};
+  const PCISubsystemRecord* _subsystem_table{nullptr};
+  size_t _num_subsystems{0};
+  const PCIClassRecord* _class_table{nullptr};
+  size_t _num_classes{0};
+  pci::Names _names_lookup{nullptr, nullptr};
+  size_t _names_size{0};
+
+  // storage of parsed tables
+  pci::Tables _tables;
+
+  // mmapped index, or mmapped ids file in lazy mode
+  void* _mapping{nullptr};
+  size_t _mapping_size{0};
+
+  // lazy mode: text of the ids file (mmapped or in _text_storage) and the vendors found in it
+  const char* _text{nullptr};
+  size_t _text_size{0};
+  std::string _text_storage;
+  std::unique_ptr<pci::LazyVendor[]> _lazy_vendors;
+  mutable std::mutex _lazy_mutex;
+};
 
-    static std::string path = getenv("HOME");
-    static PCIMapper mapper(path + "/.hwinfo/pci.ids");
-    return mapper;
+/**
+ * The PCI ID database (pci.ids): vendors, devices and subsystems of PCI functions.
+ */
+class PCIMapper : public IDMapper {
+ public:
+  using IDMapper::IDMapper;
+};
+
+namespace pci {
+
+/**
+ * true if directory exists and can be written, or could be created (its first existing ancestor can be written).
+ * Nothing is created.
+ */
+inline bool writable_directory(const std::string& directory) {
+#if defined(HWINFO_UNIX) || defined(HWINFO_APPLE)
+  if (access(directory.c_str(), F_OK) == 0) {
+    return access(directory.c_str(), W_OK) == 0;
+  }
+  const auto slash = directory.rfind('/');
+  return slash != std::string::npos && slash != 0 && writable_directory(directory.substr(0, slash));
+#else
+  (void)directory;
+  return false;
+#endif
+}
+
+/**
+ * Where the binary index of ids_file lives: in $HOME/.hwinfo, or in $XDG_CACHE_HOME/hwinfo without a home directory.
+ * Never next to ids_file, which mostly is in a directory of the package manager (/usr/share/hwdata). The file name
+ * holds a hash of the canonical path of ids_file, so that ids files of the same name (pci.ids of hwdata and of
+ * $HOME/.hwinfo) get an index each. Empty (no index) if neither directory can be written. The directory is created by
+ * IDMapper::write_index(), not here.
+ */
+inline std::string index_path(const std::string& ids_file) {
+#if defined(HWINFO_UNIX) || defined(HWINFO_APPLE)
+  std::string canonical = ids_file;
+  if (char* resolved = realpath(ids_file.c_str(), nullptr)) {
+    canonical = resolved;
+    free(resolved);
+  }
+  // FNV-1a
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (char c : canonical) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+  }
+  char hex[17];
+  std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+  const auto slash = canonical.rfind('/');
+  const std::string name = (slash == std::string::npos ? canonical : canonical.substr(slash + 1)) + '.' + hex + ".idx";
+  const std::string home = utils::get_hwinfo_directory();
+  if (!home.empty() && writable_directory(home)) {
+    return home + '/' + name;
+  }
+  const std::string xdg_cache = utils::get_env("XDG_CACHE_HOME");
+  if (!xdg_cache.empty() && writable_directory(xdg_cache + "/hwinfo")) {
+    return xdg_cache + "/hwinfo/" + name;
+  }
+#else
+  (void)ids_file;
+#endif
+  return "";
+}
+
+/**
+ * Mapper on the first readable file of candidates: from its binary index if one can be kept, lazily parsed
+ * otherwise. An empty mapper if none of the files can be read.
+ */
+template <typename Mapper>
+std::shared_ptr<const Mapper> load_mapper(const std::vector<std::string>& candidates) {
+  for (const auto& candidate : candidates) {
+    if (std::ifstream(candidate)) {
+      std::string index_file = index_path(candidate);
+      if (index_file.empty()) {
+        // nowhere to keep an index: parse only the vendors that are actually looked up
+        return std::make_shared<const Mapper>(candidate, PCIParseMode::Lazy);
+      }
+      return std::make_shared<const Mapper>(candidate, index_file);
+    }
+  }
+  return std::make_shared<const Mapper>();
+}
+
+/**
+ * Default search path for the hwdata file file_name: $HOME/.hwinfo, then the locations used by distributions.
+ */
+inline std::vector<std::string> default_candidates(const std::string& file_name) {
+  std::vector<std::string> candidates;
+  std::string directory = utils::get_hwinfo_directory();
+  if (!directory.empty()) {
+    candidates.push_back(directory + '/' + file_name);
+  }
+  candidates.push_back("/usr/share/hwdata/" + file_name);
+  candidates.push_back("/usr/share/misc/" + file_name);
+  return candidates;
+}
+
+}  // namespace pci
+
+}  // namespace hwinfo
+
+#ifdef HWINFO_EMBED_PCI_IDS
+// generated by scripts/pci_builder.py at configure time
+#include "hwinfo/pci_ids_embedded.h"
+#endif
+
+namespace hwinfo {
+
+struct PCI {
+  /**
+   * The process wide PCI ID mapper. It is built on first use (thread-safe) and shared by all callers afterwards, so
+   * pci.ids is parsed once per process instead of being copied on every call. The parsed tables are kept in a binary
+   * index in $HOME/.hwinfo (or $XDG_CACHE_HOME/hwinfo without a home directory), so that later processes only mmap the
+   * index. If no index can be
+   * written, pci.ids is parsed lazily (PCIParseMode::Lazy).
+   * Search order for pci.ids: the path set with setPath(), $HOME/.hwinfo/pci.ids, the pci.ids of the system (hwdata).
+   * If no file can be read, an empty mapper is returned, which resolves every id as "invalid".
+   * If hwinfo is built with HWINFO_EMBED_PCI_IDS, the compiled in tables are used unless setPath() was called: no
+   * file is read and $HOME is not needed.
+   */
+  static std::shared_ptr<const PCIMapper> getMapper() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.mapper) {
+      s.mapper = build();
+    }
+    return s.mapper;
+  }
+
+  /**
+   * Use pci_ids_file instead of the default search path. Mappers handed out before stay valid; the next call of
+   * getMapper() builds a new mapper from pci_ids_file.
+   */
+  static void setPath(const std::string& pci_ids_file) {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.path = pci_ids_file;
+    s.mapper.reset();
+  }
+
+ private:
+  struct State {
+    std::mutex mutex;
+    std::string path;
+    std::shared_ptr<const PCIMapper> mapper;
+  };
+
+  static State& state() {
+    static State s;
+    return s;
+  }
+
+  // called with the state locked
+  static std::shared_ptr<const PCIMapper> build() {
+    if (!state().path.empty()) {
+      return pci::load_mapper<PCIMapper>({state().path});
+    }
+#ifdef HWINFO_EMBED_PCI_IDS
+    return pci::embedded_mapper();
+#else
+    return pci::load_mapper<PCIMapper>(pci::default_candidates("pci.ids"));
+#endif
   }
 };
 
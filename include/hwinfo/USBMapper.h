@@ -0,0 +1,71 @@
+/**
+ * Copyright 2023, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of hwinfo.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "PCIMapper.h"
+
+namespace hwinfo {
+
+/**
+ * The USB ID database (usb.ids). Same format and engine as pci.ids: a vendor's "devices" are its products, the
+ * interface lines below a product are not kept.
+ */
+class USBMapper : public IDMapper {
+ public:
+  using IDMapper::IDMapper;
+};
+
+struct USB {
+  /**
+   * The process wide USB ID mapper, built on first use and shared afterwards (see PCI::getMapper()).
+   * Search order for usb.ids: the path set with setPath(), $HOME/.hwinfo/usb.ids, the usb.ids of the system (hwdata,
+   * usbutils). If no file can be read, an empty mapper is returned, which resolves every id as "invalid".
+   */
+  static std::shared_ptr<const USBMapper> getMapper() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.mapper) {
+      if (!s.path.empty()) {
+        s.mapper = pci::load_mapper<USBMapper>({s.path});
+      } else {
+        std::vector<std::string> candidates = pci::default_candidates("usb.ids");
+        candidates.emplace_back("/var/lib/usbutils/usb.ids");
+        s.mapper = pci::load_mapper<USBMapper>(candidates);
+      }
+    }
+    return s.mapper;
+  }
+
+  /**
+   * Use usb_ids_file instead of the default search path. Mappers handed out before stay valid.
+   */
+  static void setPath(const std::string& usb_ids_file) {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.path = usb_ids_file;
+    s.mapper.reset();
+  }
+
+ private:
+  struct State {
+    std::mutex mutex;
+    std::string path;
+    std::shared_ptr<const USBMapper> mapper;
+  };
+
+  static State& state() {
+    static State s;
+    return s;
+  }
+};
+
+}  // namespace hwinfo
@@ -26,6 +26,16 @@ struct Jiffies {
   int64_t working{-1};
   int64_t all{-1};
 };
+
+/**
+ * Result of a calibrated spin loop run on one logical core: the effective clock derived from the run next to the
+ * frequency the kernel reports in scaling_cur_freq (-1 if unavailable, e.g. on most VMs).
+ */
+struct ClockMeasurement {
+  int thread_id{-1};
+  int64_t measured_MHz{-1};
+  int64_t reported_MHz{-1};
+};
 #endif
 
 class CPU {
@@ -52,6 +62,19 @@ class CPU {
   // double currentTemperature_Celsius() const;
   const std::vector<std::string>& flags() const { return _flags; }
   void init_jiffies() const;
+#ifdef HWINFO_UNIX
+  /**
+   * Measure the effective clock of a logical core by running a dependency chain of single cycle integer adds pinned
+   * to that core for about duration_ms milliseconds.
+   */
+  ClockMeasurement measureClockSpeed_MHz(int thread_id, int duration_ms = 10) const;
+  /**
+   * Measure the effective clock of the given logical cores (all cores of this socket if empty). If parallel is true,
+   * all cores are loaded at the same time, which exposes thermally throttled or power limited sockets.
+   */
+  std::vector<ClockMeasurement> measureClockSpeed_MHz(const std::vector<int>& thread_ids = {}, int duration_ms = 10,
+                                                      bool parallel = true) const;
+#endif
 
  private:
   CPU() = default;
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "platform.h"
+
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -32,6 +34,58 @@ class Disk {
 
 std::vector<Disk> getAllDisks();
 
+#ifdef HWINFO_UNIX
+enum class StorageWorkload { SequentialWrite, SequentialRead, RandomRead };
+
+struct StorageProbeOptions {
+  // size of the scratch file created inside the probed directory
+  int64_t file_size_Bytes{256 * 1024 * 1024};
+  int64_t sequential_block_Bytes{1024 * 1024};
+  int64_t random_block_Bytes{4096};
+  int sequential_queue_depth{4};
+  // queue depths for the random read sweep
+  std::vector<int> queue_depths{1, 4, 16, 32};
+  // upper bound for the runtime of each single workload
+  int duration_ms{1000};
+  // use io_uring if the kernel supports it, otherwise (or if false) a thread pool issuing pread/pwrite
+  bool use_io_uring{true};
+};
+
+struct StorageProbeResult {
+  StorageWorkload workload{StorageWorkload::RandomRead};
+  int64_t block_Bytes{-1};
+  int queue_depth{-1};
+  int64_t operations{0};
+  // bytes actually transferred (short reads and writes count with what they moved)
+  int64_t transferred_Bytes{0};
+  // false if an operation failed: the numbers then only cover the run up to the error and should not be reported
+  bool valid{true};
+  // description of the first error, empty if valid
+  std::string error;
+  double throughput_MBps{-1};
+  double iops{-1};
+  double latency_p50_us{-1};
+  double latency_p99_us{-1};
+};
+
+struct StorageProbe {
+  std::string path;
+  // "io_uring" or "pread"
+  std::string engine;
+  // false if the filesystem does not support O_DIRECT (e.g. tmpfs); reads may then be served from the page cache
+  bool direct_io{false};
+  std::vector<StorageProbeResult> results;
+};
+
+/**
+ * Measure sequential write/read throughput and random read IOPS with a queue depth sweep on the filesystem that holds
+ * directory. A scratch file of options.file_size_Bytes is created (and removed again) inside directory.
+ * Throws std::runtime_error if the scratch file cannot be created.
+ */
+StorageProbe probeStorage(const std::string& directory, const StorageProbeOptions& options = StorageProbeOptions());
+#endif
+
+
 }  // namespace hwinfo
 
 #if defined(HWINFO_APPLE)
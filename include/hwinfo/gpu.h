@@ -11,8 +11,19 @@
 
 namespace hwinfo {
 
+// a memory BAR (base address register) of a PCI device
+struct GPUBar {
+  int index{-1};
+  int64_t size_Bytes{0};
+  bool prefetchable{false};
+  bool is_64bit{false};
+};
+
 class GPU {
   friend std::vector<GPU> getAllGPUs();
+#ifdef HWINFO_UNIX
+  friend std::vector<GPU> getAllGPUs(const std::string& sysfs_root);
+#endif
 
  public:
   ~GPU() = default;
@@ -24,6 +35,17 @@ class GPU {
   HWI_NODISCARD int64_t frequency_MHz() const { return _frequency_MHz; }
   HWI_NODISCARD int num_cores() const { return _num_cores; }
   HWI_NODISCARD int id() const { return _id; }
+  // "0000:01:00.0" (domain:bus:device.function), empty if unknown
+  HWI_NODISCARD const std::string& pciAddress() const { return _pci_address; }
+  // DRM render node ("renderD128", Linux), empty if the driver has none
+  HWI_NODISCARD const std::string& renderNode() const { return _render_node; }
+  // memory BARs of the device (Linux), the VRAM aperture is the largest prefetchable one
+  HWI_NODISCARD const std::vector<GPUBar>& bars() const { return _bars; }
+  /**
+   * true if the CPU can address the whole VRAM through one BAR (resizable BAR), instead of a 256 MiB window. If the
+   * VRAM size is unknown (e.g. nvidia), an aperture above 256 MiB is taken as resized.
+   */
+  HWI_NODISCARD bool resizableBar() const { return _resizable_bar; }
 
  private:
   GPU() = default;
@@ -34,12 +56,135 @@ class GPU {
   int64_t _frequency_MHz{0};
   int _num_cores{0};
   int _id{0};
+  std::string _pci_address{};
+  std::string _render_node{};
+  std::vector<GPUBar> _bars{};
+  bool _resizable_bar{false};
 
   std::string _vendor_id{};
   std::string _device_id{};
 };
 
 std::vector<GPU> getAllGPUs();
+
+#ifdef HWINFO_UNIX
+/**
+ * GPUs with a DRM node in <sysfs_root>/class/drm, one per PCI device, sorted by card number. The id is the number of
+ * the card node (/dev/dri/card<id>), or -1 for devices with a render node only (compute accelerators).
+ */
+std::vector<GPU> getAllGPUs(const std::string& sysfs_root);
+
+#ifdef USE_OCL
+/**
+ * The OpenCL details of the GPUs (driver version, clock, cores, memory) are queried once per process on a background
+ * thread and matched by PCI address (cl_khr_pci_bus_info). getAllGPUs() waits at most timeout_ms (default: 1000) for
+ * that query; GPUs returned before it completed lack these details.
+ */
+void setOpenCLTimeout_ms(int timeout_ms);
+#endif
+
+/**
+ * Telemetry of one GPU at one point in time. Values the driver does not report are -1.
+ */
+struct GPUSample {
+  static constexpr int max_fans = 4;
+  // GPU::id() of the GPU
+  int id{-1};
+  int busy_percent{-1};
+  int64_t vram_used_Bytes{-1};
+  int64_t vram_total_Bytes{-1};
+  // actual frequency of the graphics engine (gt_act_freq_mhz, hwmon freq1_input), else the requested one
+  int64_t frequency_MHz{-1};
+  double power_W{-1};
+  double temperature_C{-1};
+  int fan_RPM[max_fans]{-1, -1, -1, -1};
+};
+
+/**
+ * Samples utilisation, VRAM, frequency, power, temperature and fans of all GPUs. The sysfs and hwmon files are opened
+ * once in the constructor; a sample costs one pread per value and no allocation.
+ */
+class GPUSampler {
+ public:
+  explicit GPUSampler(const std::string& sysfs_root = "/sys");
+  ~GPUSampler();
+  GPUSampler(const GPUSampler&) = delete;
+  GPUSampler& operator=(const GPUSampler&) = delete;
+
+  // number of GPUs, in the order of getAllGPUs(sysfs_root)
+  HWI_NODISCARD size_t size() const { return _samples.size(); }
+  // one record per GPU; the returned vector is reused by the next call
+  const std::vector<GPUSample>& sample();
+
+ private:
+  struct Files {
+    int busy{-1};
+    int vram_used{-1};
+    int frequency{-1};
+    // hwmon frequency is in Hz
+    bool frequency_Hz{false};
+    int power{-1};
+    int temperature{-1};
+    int fans[GPUSample::max_fans]{-1, -1, -1, -1};
+  };
+  std::vector<Files> _files;
+  std::vector<GPUSample> _samples;
+};
+
+struct GPUEngineUsage {
+  // as named by the driver: "gfx", "compute", "dec", "render", "video", ...
+  std::string name;
+  // accumulated busy time since the DRM clients were opened
+  uint64_t busy_ns{0};
+  // number of engines of this class the busy time is summed over
+  int capacity{1};
+  // busy share of the engine class in the sampled interval (GPUProcessSampler), -1 otherwise
+  double utilisation_percent{-1};
+};
+
+/**
+ * GPU usage of one process on one GPU, summed over the DRM clients (open render/card nodes) of the process, from the
+ * drm-* keys of /proc/<pid>/fdinfo.
+ */
+struct GPUProcess {
+  int pid{-1};
+  std::string name;
+  // drm-pdev, "0000:01:00.0"
+  std::string pci_address;
+  std::string driver;
+  std::vector<GPUEngineUsage> engines;
+  // resident GPU memory over all regions (drm-resident-*, or drm-memory-* of older kernels)
+  int64_t memory_Bytes{0};
+  // drm-client-id of the clients
+  std::vector<uint64_t> client_ids;
+  // highest engine utilisation (GPUProcessSampler), -1 otherwise
+  double utilisation_percent{-1};
+};
+
+/**
+ * Processes that have a DRM client open, one entry per process and GPU, sorted by pid. The pids are scanned on
+ * threads worker threads (0: one per core). A client shared by several processes (inherited or passed fd) is counted
+ * for the lowest pid only. Processes of other users are only visible with CAP_SYS_PTRACE.
+ */
+std::vector<GPUProcess> getGPUProcesses(const std::string& proc_root = "/proc", int threads = 0);
+
+/**
+ * Delta mode of getGPUProcesses(): sample() reports the engine utilisation of each process since the previous call
+ * (the first call: since construction).
+ */
+class GPUProcessSampler {
+ public:
+  explicit GPUProcessSampler(const std::string& proc_root = "/proc", int threads = 0);
+
+  std::vector<GPUProcess> sample();
+
+ private:
+  std::string _proc_root;
+  int _threads;
+  std::vector<GPUProcess> _previous;
+  int64_t _previous_ns;
+};
+#endif
 }  // namespace hwinfo
 
 #if defined(HWINFO_APPLE)
@@ -8,5 +8,11 @@
 #include "disk.h"
 #include "gpu.h"
 #include "mainboard.h"
+#include "memory_pages.h"
 #include "os.h"
-#include "ram.h"
\ No newline at end of file
+#include "pci.h"
+#include "pressure.h"
+#include "ram.h"
+#include "smbios.h"
+#include "usb.h"
+#include "vmstat.h"
\ No newline at end of file
@@ -5,15 +5,19 @@
 
 #ifdef HWINFO_UNIX
 
+#include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <sstream>
 #include <string>
@@ -59,6 +63,16 @@ int64_t getMinClockSpeed_MHz(const int& core_id) {
   return -1;
 }
 
+// _____________________________________________________________________________________________________________________
+int64_t CPU::currentClockSpeed_MHz(int thread_id) const {
+  int64_t frequency_Hz = filesystem::get_specs_by_file_path("/sys/devices/system/cpu/cpu" + std::to_string(thread_id) +
+                                                            "/cpufreq/scaling_cur_freq");
+  if (frequency_Hz > -1) {
+    return frequency_Hz / 1000;
+  }
+  return -1;
+}
+
 // _____________________________________________________________________________________________________________________
 std::vector<int64_t> CPU::currentClockSpeed_MHz() const {
   std::vector<int64_t> res;
@@ -139,6 +153,165 @@ void CPU::init_jiffies() const {
   }
 }
 
+// number of dependent adds executed per iteration of run_dependency_chain()
+static const uint64_t chain_ops_per_iteration = 32;
+
+// _____________________________________________________________________________________________________________________
+/**
+ * Run iterations * chain_ops_per_iteration dependent integer adds. Register-register adds have a latency of one cycle
+ * on every core we care about, so the runtime of the chain is a direct measure of the core clock. The loop is written
+ * in assembly where possible so that the result does not depend on the optimization level. step is not a compile time
+ * constant on purpose: some cores eliminate chains of immediate adds at register rename.
+ */
+uint64_t run_dependency_chain(uint64_t iterations, uint64_t step) {
+  uint64_t x = iterations;
+  if (iterations == 0) {
+    return x;
+  }
+#if defined(HWINFO_X86_64)
+  __asm__ volatile(
+      "1:\n\t"
+      ".rept 32\n\t"
+      "add %[step], %[x]\n\t"
+      ".endr\n\t"
+      "dec %[n]\n\t"
+      "jnz 1b"
+      : [x] "+r"(x), [n] "+r"(iterations)
+      : [step] "r"(step)
+      : "cc");
+#elif defined(__aarch64__)
+  __asm__ volatile(
+      "1:\n\t"
+      ".rept 32\n\t"
+      "add %[x], %[x], %[step]\n\t"
+      ".endr\n\t"
+      "subs %[n], %[n], #1\n\t"
+      "b.ne 1b"
+      : [x] "+r"(x), [n] "+r"(iterations)
+      : [step] "r"(step)
+      : "cc");
+#else
+  __asm__ volatile("" : "+r"(step));
+  for (uint64_t i = 0; i < iterations; ++i) {
+    for (uint64_t op = 0; op < chain_ops_per_iteration; ++op) {
+      x += step;
+      // keeps the compiler from folding consecutive adds into one
+      __asm__ volatile("" : "+r"(x));
+    }
+  }
+#endif
+  return x;
+}
+
+// _____________________________________________________________________________________________________________________
+/**
+ * Time run_dependency_chain(iterations) and return the number of seconds it took.
+ */
+double time_dependency_chain(uint64_t iterations) {
+  auto start = std::chrono::steady_clock::now();
+  volatile uint64_t sink = run_dependency_chain(iterations, 1);
+  (void)sink;
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+// _____________________________________________________________________________________________________________________
+/**
+ * Pin the calling thread to thread_id, calibrate the iteration count so that one run takes about duration_ms, and
+ * return the best of a few runs in MHz. Taking the fastest run filters out preemption and interrupts. Returns -1 if
+ * the thread could not be pinned.
+ */
+int64_t measure_pinned_clock_MHz(int thread_id, int duration_ms) {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(thread_id, &cpu_set);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+    return -1;
+  }
+  // calibration: grow the run until it takes at least 1ms, which also wakes the core from idle states
+  uint64_t iterations = 1 << 12;
+  double seconds = time_dependency_chain(iterations);
+  while (seconds < 1e-3) {
+    iterations *= 2;
+    seconds = time_dependency_chain(iterations);
+  }
+  const double target_seconds = std::max(duration_ms, 1) / 1000.0;
+  iterations = std::max<uint64_t>(1, static_cast<uint64_t>(static_cast<double>(iterations) * target_seconds / seconds));
+
+  double best = std::numeric_limits<double>::max();
+  for (int run = 0; run < 3; ++run) {
+    best = std::min(best, time_dependency_chain(iterations));
+  }
+  const double ops = static_cast<double>(iterations * chain_ops_per_iteration);
+  return static_cast<int64_t>(std::round(ops / best / 1e6));
+}
+
+// _____________________________________________________________________________________________________________________
+ClockMeasurement CPU::measureClockSpeed_MHz(int thread_id, int duration_ms) const {
+  ClockMeasurement measurement;
+  measurement.thread_id = thread_id;
+  // run on a separate thread so that the affinity of the calling thread stays untouched
+  std::thread worker([&measurement, thread_id, duration_ms]() {
+    measurement.measured_MHz = measure_pinned_clock_MHz(thread_id, duration_ms);
+  });
+  worker.join();
+  measurement.reported_MHz = currentClockSpeed_MHz(thread_id);
+  return measurement;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<ClockMeasurement> CPU::measureClockSpeed_MHz(const std::vector<int>& thread_ids, int duration_ms,
+                                                         bool parallel) const {
+  std::vector<int> targets(thread_ids);
+  if (targets.empty()) {
+    // all logical cores of this socket
+    for (int thread_id = 0; /* breaks, if thread_id is no valid cpu id */; ++thread_id) {
+      const std::string topology("/sys/devices/system/cpu/cpu" + std::to_string(thread_id) + "/topology/");
+      if (!filesystem::exists(topology)) {
+        break;
+      }
+      int64_t package_id = filesystem::get_specs_by_file_path(topology + "physical_package_id");
+      if (package_id == -1 || _id == -1 || package_id == _id) {
+        targets.push_back(thread_id);
+      }
+    }
+  }
+
+  std::vector<ClockMeasurement> measurements(targets.size());
+  if (!parallel) {
+    for (size_t i = 0; i < targets.size(); ++i) {
+      measurements[i] = measureClockSpeed_MHz(targets[i], duration_ms);
+    }
+    return measurements;
+  }
+
+  // all workers wait until every worker is pinned, so that the cores are loaded at the same time
+  std::atomic<size_t> ready(0);
+  std::vector<std::thread> workers;
+  workers.reserve(targets.size());
+  for (size_t i = 0; i < targets.size(); ++i) {
+    workers.emplace_back([this, &measurements, &targets, &ready, i, duration_ms]() {
+      ClockMeasurement& measurement = measurements[i];
+      measurement.thread_id = targets[i];
+      cpu_set_t cpu_set;
+      CPU_ZERO(&cpu_set);
+      CPU_SET(targets[i], &cpu_set);
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+      ready.fetch_add(1);
+      while (ready.load() < targets.size()) {
+        std::this_thread::yield();
+      }
+      measurement.measured_MHz = measure_pinned_clock_MHz(targets[i], duration_ms);
+      // read the kernel value while the core is still busy
+      measurement.reported_MHz = currentClockSpeed_MHz(targets[i]);
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  return measurements;
+}
+
 // CPU Temp -> Works | But requires Im_sensors
 // double CPU::currentTemperature_Celsius() const {
 //     if (!std::ifstream("/etc/sensors3.conf"))
@@ -5,11 +5,25 @@
 
 #ifdef HWINFO_UNIX
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
 
 #include "../disk.h"
 #include "../utils/filesystem.h"
 #include "../utils/stringutils.h"
+#include "utils/io_uring.h"
 
 namespace hwinfo {
 
@@ -63,6 +77,310 @@ std::vector<Disk> getAllDisks() {
   return disks;
 }
 
+// =====================================================================================================================
+// Storage probe
+
+/**
+ * One workload of the storage probe: at most max_operations (0: unlimited) blocks are transferred, and no new
+ * operation is issued after duration_ms (0: unlimited).
+ */
+struct StorageJob {
+  StorageWorkload workload;
+  int64_t block_Bytes;
+  int queue_depth;
+  int64_t max_operations;
+  int duration_ms;
+};
+
+/**
+ * Hands out the offsets of a job: consecutive blocks for sequential workloads, uniformly distributed aligned blocks
+ * (xorshift64) for random ones.
+ */
+class StorageOffsets {
+ public:
+  StorageOffsets(const StorageJob& job, int64_t file_size_Bytes, uint64_t seed)
+      : _sequential(job.workload != StorageWorkload::RandomRead),
+        _block(job.block_Bytes),
+        _num_blocks(std::max<int64_t>(1, file_size_Bytes / job.block_Bytes)),
+        _state(seed | 1) {}
+
+  uint64_t next(int64_t operation) {
+    if (_sequential) {
+      return static_cast<uint64_t>((operation % _num_blocks) * _block);
+    }
+    _state ^= _state << 13;
+    _state ^= _state >> 7;
+    _state ^= _state << 17;
+    return (_state % static_cast<uint64_t>(_num_blocks)) * static_cast<uint64_t>(_block);
+  }
+
+ private:
+  bool _sequential;
+  int64_t _block;
+  int64_t _num_blocks;
+  uint64_t _state;
+};
+
+// _____________________________________________________________________________________________________________________
+double storage_percentile(std::vector<double>& values, double percentile) {
+  if (values.empty()) {
+    return -1;
+  }
+  auto index = static_cast<size_t>(percentile * static_cast<double>(values.size() - 1));
+  std::nth_element(values.begin(), values.begin() + static_cast<int64_t>(index), values.end());
+  return values[index];
+}
+
+// _____________________________________________________________________________________________________________________
+StorageProbeResult summarize_storage_job(const StorageJob& job, std::vector<double>& latencies_us,
+                                         int64_t transferred_Bytes, double seconds, int error_number) {
+  // error_number: errno of the first failed operation, 0 if none
+  StorageProbeResult result;
+  result.workload = job.workload;
+  result.block_Bytes = job.block_Bytes;
+  result.queue_depth = job.queue_depth;
+  result.operations = static_cast<int64_t>(latencies_us.size());
+  result.transferred_Bytes = transferred_Bytes;
+  if (error_number != 0) {
+    result.valid = false;
+    result.error = std::strerror(error_number);
+  }
+  if (seconds > 0) {
+    result.iops = static_cast<double>(result.operations) / seconds;
+    result.throughput_MBps = static_cast<double>(transferred_Bytes) / seconds / 1e6;
+  }
+  result.latency_p50_us = storage_percentile(latencies_us, 0.5);
+  result.latency_p99_us = storage_percentile(latencies_us, 0.99);
+  return result;
+}
+
+// _____________________________________________________________________________________________________________________
+/**
+ * Run job with one thread per queue slot, each issuing blocking pread/pwrite calls. The first failing call stops all
+ * slots.
+ */
+StorageProbeResult run_pread_storage_job(int fd, const StorageJob& job, int64_t file_size_Bytes,
+                                         const std::vector<char*>& buffers) {
+  typedef std::chrono::steady_clock clock;
+  const bool write = job.workload == StorageWorkload::SequentialWrite;
+  const auto start = clock::now();
+  const auto deadline = start + std::chrono::milliseconds(job.duration_ms);
+  std::atomic<int64_t> issued(0);
+  std::atomic<int64_t> transferred(0);
+  std::atomic<int> error_number(0);
+  std::vector<std::vector<double>> latencies(static_cast<size_t>(job.queue_depth));
+  std::vector<std::thread> workers;
+  for (int slot = 0; slot < job.queue_depth; ++slot) {
+    workers.emplace_back([&, slot]() {
+      StorageOffsets offsets(job, file_size_Bytes, 0x9e3779b97f4a7c15ULL * static_cast<uint64_t>(slot + 1));
+      std::vector<double>& slot_latencies = latencies[static_cast<size_t>(slot)];
+      while (true) {
+        auto now = clock::now();
+        if ((job.duration_ms > 0 && now >= deadline) || error_number.load(std::memory_order_relaxed) != 0) {
+          break;
+        }
+        int64_t operation = issued.fetch_add(1);
+        if (job.max_operations > 0 && operation >= job.max_operations) {
+          break;
+        }
+        auto offset = static_cast<off_t>(offsets.next(operation));
+        auto size = static_cast<size_t>(job.block_Bytes);
+        ssize_t ret = write ? pwrite(fd, buffers[static_cast<size_t>(slot)], size, offset)
+                            : pread(fd, buffers[static_cast<size_t>(slot)], size, offset);
+        if (ret < 0) {
+          int expected = 0;
+          error_number.compare_exchange_strong(expected, errno);
+          break;
+        }
+        transferred.fetch_add(ret, std::memory_order_relaxed);
+        slot_latencies.push_back(std::chrono::duration<double, std::micro>(clock::now() - now).count());
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  if (write && fdatasync(fd) != 0 && error_number == 0) {
+    error_number = errno;
+  }
+  const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+  std::vector<double> all_latencies;
+  for (auto& slot_latencies : latencies) {
+    all_latencies.insert(all_latencies.end(), slot_latencies.begin(), slot_latencies.end());
+  }
+  return summarize_storage_job(job, all_latencies, transferred, seconds, error_number);
+}
+
+#ifdef HWINFO_HAS_IO_URING
+// _____________________________________________________________________________________________________________________
+/**
+ * Run job on an io_uring keeping queue_depth operations in flight. Returns false if io_uring is not usable (setup
+ * blocked, or the kernel rejects the read/write opcodes), in which case the caller falls back to pread.
+ */
+bool run_io_uring_storage_job(int fd, const StorageJob& job, int64_t file_size_Bytes,
+                              const std::vector<char*>& buffers, StorageProbeResult& result) {
+  typedef std::chrono::steady_clock clock;
+  utils::IoUring ring(static_cast<unsigned>(job.queue_depth));
+  if (!ring.valid()) {
+    return false;
+  }
+  const bool write = job.workload == StorageWorkload::SequentialWrite;
+  StorageOffsets offsets(job, file_size_Bytes, 0x9e3779b97f4a7c15ULL);
+  std::vector<clock::time_point> submitted(static_cast<size_t>(job.queue_depth));
+  std::vector<double> latencies;
+  const auto start = clock::now();
+  const auto deadline = start + std::chrono::milliseconds(job.duration_ms);
+  int64_t issued = 0;
+  int64_t transferred = 0;
+  int error_number = 0;
+  int in_flight = 0;
+
+  auto issue = [&](size_t slot) -> bool {
+    auto now = clock::now();
+    if ((job.duration_ms > 0 && now >= deadline) || (job.max_operations > 0 && issued >= job.max_operations) ||
+        error_number != 0) {
+      return false;
+    }
+    if (!ring.prepare(write, fd, buffers[slot], static_cast<unsigned>(job.block_Bytes), offsets.next(issued), slot)) {
+      return false;
+    }
+    submitted[slot] = now;
+    issued++;
+    in_flight++;
+    return true;
+  };
+
+  for (size_t slot = 0; slot < submitted.size(); ++slot) {
+    if (!issue(slot)) {
+      break;
+    }
+  }
+  while (in_flight > 0) {
+    int ret = ring.submit_and_wait(1);
+    if (ret < 0 && ret != -EINTR) {
+      if (latencies.empty()) {
+        return false;
+      }
+      error_number = -ret;
+      break;
+    }
+    uint64_t slot = 0;
+    int res = 0;
+    while (ring.pop(slot, res)) {
+      in_flight--;
+      if (res < 0) {
+        if (latencies.empty()) {
+          // drain the remaining operations before giving up on io_uring
+          while (in_flight > 0 && ring.submit_and_wait(1) >= 0) {
+            while (ring.pop(slot, res)) {
+              in_flight--;
+            }
+          }
+          return false;
+        }
+        // no further operations; the ones in flight complete
+        if (error_number == 0) {
+          error_number = -res;
+        }
+        continue;
+      }
+      transferred += res;
+      latencies.push_back(std::chrono::duration<double, std::micro>(clock::now() - submitted[slot]).count());
+      issue(static_cast<size_t>(slot));
+    }
+  }
+  if (write && fdatasync(fd) != 0 && error_number == 0) {
+    error_number = errno;
+  }
+  const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+  result = summarize_storage_job(job, latencies, transferred, seconds, error_number);
+  return true;
+}
+#endif  // HWINFO_HAS_IO_URING
+
+// _____________________________________________________________________________________________________________________
+StorageProbe probeStorage(const std::string& directory, const StorageProbeOptions& options) {
+  StorageProbe probe;
+  probe.path = directory;
+
+  std::string scratch_path(directory + "/.hwinfo-storage-probe-XXXXXX");
+  int scratch_fd = mkstemp(&scratch_path[0]);
+  if (scratch_fd < 0) {
+    throw std::runtime_error("ERROR: Could not create scratch file in '" + directory + "'.\n");
+  }
+  close(scratch_fd);
+  int fd = open(scratch_path.c_str(), O_RDWR | O_DIRECT);
+  probe.direct_io = fd >= 0;
+  if (fd < 0) {
+    // e.g. tmpfs does not support O_DIRECT
+    fd = open(scratch_path.c_str(), O_RDWR);
+  }
+  // the file is removed as soon as it is closed, even if we do not return normally
+  unlink(scratch_path.c_str());
+  if (fd < 0) {
+    throw std::runtime_error("ERROR: Could not open scratch file in '" + directory + "'.\n");
+  }
+
+  int max_queue_depth = std::max(options.sequential_queue_depth, 1);
+  for (int queue_depth : options.queue_depths) {
+    max_queue_depth = std::max(max_queue_depth, queue_depth);
+  }
+  const int64_t buffer_size = std::max(options.sequential_block_Bytes, options.random_block_Bytes);
+  // O_DIRECT requires buffers aligned to the logical block size, page alignment covers every device
+  std::vector<std::unique_ptr<char, void (*)(void*)>> buffer_storage;
+  std::vector<char*> buffers;
+  for (int slot = 0; slot < max_queue_depth; ++slot) {
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, 4096, static_cast<size_t>(buffer_size)) != 0) {
+      close(fd);
+      throw std::bad_alloc();
+    }
+    // random content, so that compressing or deduplicating devices cannot cheat
+    auto* bytes = static_cast<unsigned char*>(buffer);
+    for (int64_t i = 0; i < buffer_size; ++i) {
+      bytes[i] = static_cast<unsigned char>((i * 2654435761ULL + static_cast<uint64_t>(slot)) >> 13);
+    }
+    buffer_storage.emplace_back(static_cast<char*>(buffer), &free);
+    buffers.push_back(static_cast<char*>(buffer));
+  }
+
+  std::vector<StorageJob> jobs;
+  const int64_t sequential_blocks = std::max<int64_t>(1, options.file_size_Bytes / options.sequential_block_Bytes);
+  // the write lays out the whole file (no time limit), so that the reads hit allocated blocks
+  jobs.push_back({StorageWorkload::SequentialWrite, options.sequential_block_Bytes,
+                  std::max(options.sequential_queue_depth, 1), sequential_blocks, 0});
+  jobs.push_back({StorageWorkload::SequentialRead, options.sequential_block_Bytes,
+                  std::max(options.sequential_queue_depth, 1), sequential_blocks, options.duration_ms});
+  for (int queue_depth : options.queue_depths) {
+    jobs.push_back(
+        {StorageWorkload::RandomRead, options.random_block_Bytes, std::max(queue_depth, 1), 0, options.duration_ms});
+  }
+
+  bool use_io_uring = options.use_io_uring;
+#ifndef HWINFO_HAS_IO_URING
+  use_io_uring = false;
+#endif
+  for (const auto& job : jobs) {
+    if (job.workload != StorageWorkload::SequentialWrite && !probe.direct_io) {
+      // without O_DIRECT at least start every read workload with a cold page cache
+      posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    StorageProbeResult result;
+#ifdef HWINFO_HAS_IO_URING
+    if (use_io_uring) {
+      use_io_uring = run_io_uring_storage_job(fd, job, options.file_size_Bytes, buffers, result);
+    }
+#endif
+    if (!use_io_uring) {
+      result = run_pread_storage_job(fd, job, options.file_size_Bytes, buffers);
+    }
+    probe.results.push_back(result);
+  }
+  probe.engine = use_io_uring ? "io_uring" : "pread";
+  close(fd);
+  return probe;
+}
+
 }  // namespace hwinfo
 
 #endif  // HWINFO_UNIX
\ No newline at end of file
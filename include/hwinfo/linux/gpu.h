@@ -1,4 +1,3 @@
-
 // Copyright Leon Freist
 // Author Leon Freist <freist@informatik.uni-freiburg.de>
 
@@ -6,14 +5,35 @@
 
 #ifdef HWINFO_UNIX
 
-#include "../PCIMapper.h"
-#include "../gpu.h"
-#include "../utils/filesystem.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <iterator>
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "../PCIMapper.h"
+#include "../gpu.h"
+#include "../utils/filesystem.h"
+
+#ifdef USE_OCL
+#include <CL/cl.h>
+#include <CL/cl_ext.h>
+
+#include <atomic>
+#include <cstdio>
+#include <future>
+#endif
+
 namespace hwinfo {
 
 // _____________________________________________________________________________________________________________________
@@ -39,56 +59,342 @@ std::vector<int> get_frequencies(const std::string drm_path) {
   try {
     freqs[1] = std::stoi(read_drm_by_path(drm_path + "gt_cur_freq_mhz"));
   } catch (const std::invalid_argument& e) {
-    freqs[0] = -1;
+    freqs[1] = -1;
   }
   try {
     freqs[2] = std::stoi(read_drm_by_path(drm_path + "gt_max_freq_mhz"));
   } catch (const std::invalid_argument& e) {
-    freqs[0] = -1;
+    freqs[2] = -1;
   }
   return freqs;
 }
 
 // _____________________________________________________________________________________________________________________
-std::vector<GPU> getAllGPUs() {
-  std::vector<GPU> gpus{};
-  PCIMapper pci = PCI::getMapper();
-  int id = 0;
-  while (true) {
-    GPU gpu;
-    gpu._id = id;
-    std::string path("/sys/class/drm/card" + std::to_string(id) + '/');
-    if (!filesystem::exists(path)) {
-      if (id > 2) {
-        break;
+bool parse_drm_node(const std::string& entry, const char* prefix, int& number) {
+  // "card0" or "renderD128"; connectors ("card0-HDMI-A-1") and other entries do not match
+  const size_t length = std::strlen(prefix);
+  if (entry.size() == length || entry.compare(0, length, prefix) != 0) {
+    return false;
+  }
+  number = 0;
+  for (size_t i = length; i < entry.size(); ++i) {
+    if (entry[i] < '0' || entry[i] > '9') {
+      return false;
+    }
+    number = number * 10 + (entry[i] - '0');
+  }
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+std::string drm_device_address(const std::string& node_path) {
+  // "device" links to the parent device, for PCI devices "../../../0000:01:00.0"
+  char target[PATH_MAX];
+  ssize_t size = readlink((node_path + "device").c_str(), target, sizeof(target));
+  if (size <= 0) {
+    return "";
+  }
+  std::string link(target, static_cast<size_t>(size));
+  return link.substr(link.rfind('/') + 1);
+}
+
+struct DRMDevice {
+  std::string pci_address;
+  std::string vendor_id;
+  std::string device_id;
+  // card number, -1 if the device only has a render node
+  int card{-1};
+  std::string render_node;
+  // sysfs directory of the card node (of the render node if there is no card), with trailing '/'
+  std::string node_path;
+};
+
+// _____________________________________________________________________________________________________________________
+std::vector<DRMDevice> scan_drm_devices(const std::string& sysfs_root) {
+  std::vector<DRMDevice> devices;
+  const std::string drm_path(sysfs_root + "/class/drm/");
+  for (const auto& entry : filesystem::getDirectoryEntries(drm_path)) {
+    int number = 0;
+    const bool card = parse_drm_node(entry, "card", number);
+    if (!card && !parse_drm_node(entry, "renderD", number)) {
+      continue;
+    }
+    const std::string path(drm_path + entry + '/');
+    const std::string address = drm_device_address(path);
+    if (address.empty()) {
+      continue;
+    }
+    // the card and the render node of a device share it
+    auto device = std::find_if(devices.begin(), devices.end(),
+                               [&address](const DRMDevice& d) { return d.pci_address == address; });
+    if (device == devices.end()) {
+      DRMDevice new_device;
+      new_device.vendor_id = read_drm_by_path(path + "device/vendor");
+      new_device.device_id = read_drm_by_path(path + "device/device");
+      if (new_device.vendor_id.empty() || new_device.device_id.empty()) {
+        // not a PCI device (e.g. the display engine of an SoC)
+        continue;
       }
-      id++;
+      new_device.pci_address = address;
+      new_device.node_path = path;
+      devices.push_back(std::move(new_device));
+      device = devices.end() - 1;
+    }
+    if (card) {
+      device->card = number;
+      device->node_path = path;
+    } else {
+      device->render_node = entry;
+    }
+  }
+  std::sort(devices.begin(), devices.end(), [](const DRMDevice& a, const DRMDevice& b) {
+    // render node only devices last
+    if (a.card != b.card) {
+      return a.card < 0 ? false : (b.card < 0 || a.card < b.card);
+    }
+    return a.pci_address < b.pci_address;
+  });
+  return devices;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<GPUBar> read_pci_bars(const std::string& device_path) {
+  // one line per resource, "<start> <end> <flags>": lines 0-5 are the BARs, line 6 is the expansion ROM
+  const uint64_t memory_flag = 0x200;        // IORESOURCE_MEM
+  const uint64_t prefetch_flag = 0x2000;     // IORESOURCE_PREFETCH
+  const uint64_t memory_64_flag = 0x100000;  // IORESOURCE_MEM_64
+  std::vector<GPUBar> bars;
+  std::ifstream resource(device_path + "resource");
+  std::string line;
+  for (int index = 0; index < 6 && std::getline(resource, line); ++index) {
+    char* end = nullptr;
+    const uint64_t start = std::strtoull(line.c_str(), &end, 16);
+    const uint64_t last = std::strtoull(end, &end, 16);
+    const uint64_t flags = std::strtoull(end, &end, 16);
+    if ((flags & memory_flag) == 0 || last <= start) {
       continue;
     }
-    gpu._vendor_id = read_drm_by_path(path + "device/vendor");
-    gpu._device_id = read_drm_by_path(path + "device/device");
-    if (gpu._vendor_id.empty() || gpu._device_id.empty()) {
-      id++;
+    GPUBar bar;
+    bar.index = index;
+    bar.size_Bytes = static_cast<int64_t>(last - start + 1);
+    bar.prefetchable = (flags & prefetch_flag) != 0;
+    bar.is_64bit = (flags & memory_64_flag) != 0;
+    bars.push_back(bar);
+  }
+  return bars;
+}
+
+// _____________________________________________________________________________________________________________________
+bool is_resizable_bar_active(const std::vector<GPUBar>& bars, int64_t vram_Bytes) {
+  // without resizable BAR the VRAM aperture is 256 MiB (rarely less) whatever the VRAM size
+  const int64_t legacy_aperture_Bytes = 256LL * 1024 * 1024;
+  int64_t aperture_Bytes = 0;
+  for (const auto& bar : bars) {
+    if (bar.prefetchable && bar.size_Bytes > aperture_Bytes) {
+      aperture_Bytes = bar.size_Bytes;
+    }
+  }
+  if (vram_Bytes > legacy_aperture_Bytes) {
+    return aperture_Bytes >= vram_Bytes;
+  }
+  return aperture_Bytes > legacy_aperture_Bytes;
+}
+
+#ifdef USE_OCL
+struct OpenCLGPU {
+  // "0000:01:00.0", from cl_khr_pci_bus_info
+  std::string pci_address;
+  std::string driver_version;
+  int64_t frequency_MHz{0};
+  int num_cores{0};
+  int64_t memory_Bytes{0};
+};
+
+// _____________________________________________________________________________________________________________________
+std::string ocl_device_string(cl_device_id device, cl_device_info param) {
+  size_t size = 0;
+  if (clGetDeviceInfo(device, param, 0, nullptr, &size) != CL_SUCCESS || size == 0) {
+    return "";
+  }
+  std::string value(size, '\0');
+  if (clGetDeviceInfo(device, param, size, &value[0], nullptr) != CL_SUCCESS) {
+    return "";
+  }
+  value.resize(std::strlen(value.c_str()));
+  return value;
+}
+
+// _____________________________________________________________________________________________________________________
+int ocl_cores_per_compute_unit(cl_device_id device, cl_uint vendor_id) {
+  switch (vendor_id) {
+    case 0x10de: {
+      // CUDA cores per SM, by compute capability (cl_nv_device_attribute_query)
+      cl_uint major = 0;
+      cl_uint minor = 0;
+      clGetDeviceInfo(device, CL_DEVICE_COMPUTE_CAPABILITY_MAJOR_NV, sizeof(major), &major, nullptr);
+      clGetDeviceInfo(device, CL_DEVICE_COMPUTE_CAPABILITY_MINOR_NV, sizeof(minor), &minor, nullptr);
+      switch (major) {
+        case 2:
+          return minor == 1 ? 48 : 32;
+        case 3:
+          return 192;
+        case 6:
+        case 8:
+          return minor == 0 ? 64 : 128;
+        case 7:
+          return 64;
+        default:
+          return 128;
+      }
+    }
+    case 0x1002:
+      // stream processors per compute unit
+      return 64;
+    case 0x8086:
+      // ALUs per execution unit
+      return 8;
+    default:
+      return 1;
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<OpenCLGPU> query_opencl_gpus() {
+  std::vector<OpenCLGPU> gpus;
+  cl_uint num_platforms = 0;
+  if (clGetPlatformIDs(0, nullptr, &num_platforms) != CL_SUCCESS || num_platforms == 0) {
+    return gpus;
+  }
+  std::vector<cl_platform_id> platforms(num_platforms);
+  if (clGetPlatformIDs(num_platforms, platforms.data(), nullptr) != CL_SUCCESS) {
+    return gpus;
+  }
+  for (cl_platform_id platform : platforms) {
+    cl_uint num_devices = 0;
+    if (clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 0, nullptr, &num_devices) != CL_SUCCESS || num_devices == 0) {
       continue;
     }
-    const PCIVendor& vendor = pci[gpu._vendor_id];
-    const PCIDevice device = vendor[gpu._device_id];
-    gpu._vendor = vendor.vendor_name;
-    gpu._name = vendor[gpu._device_id].device_name;
-    auto frequencies = get_frequencies(path);
-    gpu._frequency_MHz = frequencies[2];
+    std::vector<cl_device_id> devices(num_devices);
+    if (clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, num_devices, devices.data(), nullptr) != CL_SUCCESS) {
+      continue;
+    }
+    for (cl_device_id device : devices) {
+      // devices without the extension cannot be told apart reliably, e.g. two cards of the same model
+      if (ocl_device_string(device, CL_DEVICE_EXTENSIONS).find("cl_khr_pci_bus_info") == std::string::npos) {
+        continue;
+      }
+      cl_device_pci_bus_info_khr bus{};
+      if (clGetDeviceInfo(device, CL_DEVICE_PCI_BUS_INFO_KHR, sizeof(bus), &bus, nullptr) != CL_SUCCESS) {
+        continue;
+      }
+      char address[16];
+      std::snprintf(address, sizeof(address), "%04x:%02x:%02x.%x", bus.pci_domain & 0xffff, bus.pci_bus & 0xff,
+                    bus.pci_device & 0x1f, bus.pci_function & 0x7);
+      // several platforms (vendor driver, Mesa) may expose the same device: the first one wins
+      if (std::any_of(gpus.begin(), gpus.end(), [&address](const OpenCLGPU& g) { return g.pci_address == address; })) {
+        continue;
+      }
+      OpenCLGPU gpu;
+      gpu.pci_address = address;
+      gpu.driver_version = ocl_device_string(device, CL_DRIVER_VERSION);
+      cl_uint frequency_MHz = 0;
+      cl_uint compute_units = 0;
+      cl_uint vendor_id = 0;
+      cl_ulong memory_Bytes = 0;
+      clGetDeviceInfo(device, CL_DEVICE_MAX_CLOCK_FREQUENCY, sizeof(frequency_MHz), &frequency_MHz, nullptr);
+      clGetDeviceInfo(device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(compute_units), &compute_units, nullptr);
+      clGetDeviceInfo(device, CL_DEVICE_VENDOR_ID, sizeof(vendor_id), &vendor_id, nullptr);
+      clGetDeviceInfo(device, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(memory_Bytes), &memory_Bytes, nullptr);
+      gpu.frequency_MHz = static_cast<int64_t>(frequency_MHz);
+      gpu.num_cores = static_cast<int>(compute_units) * ocl_cores_per_compute_unit(device, vendor_id);
+      gpu.memory_Bytes = static_cast<int64_t>(memory_Bytes);
+      gpus.push_back(std::move(gpu));
+    }
+  }
+  return gpus;
+}
+
+// _____________________________________________________________________________________________________________________
+std::atomic<int>& opencl_timeout_ms() {
+  static std::atomic<int> timeout_ms(1000);
+  return timeout_ms;
+}
+
+// _____________________________________________________________________________________________________________________
+void setOpenCLTimeout_ms(int timeout_ms) { opencl_timeout_ms().store(timeout_ms); }
+
+// _____________________________________________________________________________________________________________________
+const std::shared_future<std::vector<OpenCLGPU>>& opencl_gpus() {
+  // loading the ICDs takes up to several hundred milliseconds: started on the first call, on its own thread, and kept
+  // for the lifetime of the process
+  static const std::shared_future<std::vector<OpenCLGPU>> gpus =
+      std::async(std::launch::async, query_opencl_gpus).share();
+  return gpus;
+}
+#endif  // USE_OCL
+
+// _____________________________________________________________________________________________________________________
+std::vector<GPU> getAllGPUs() { return getAllGPUs("/sys"); }
+
+// _____________________________________________________________________________________________________________________
+std::vector<GPU> getAllGPUs(const std::string& sysfs_root) {
+  std::vector<GPU> gpus{};
+  std::shared_ptr<const PCIMapper> pci;
+  for (const auto& device : scan_drm_devices(sysfs_root)) {
+    GPU gpu;
+    gpu._id = device.card;
+    gpu._pci_address = device.pci_address;
+    gpu._render_node = device.render_node;
+    gpu._vendor_id = device.vendor_id;
+    gpu._device_id = device.device_id;
+    if (device.card >= 0) {
+      gpu._frequency_MHz = get_frequencies(device.node_path)[2];
+    }
+    const std::string device_path(device.node_path + "device/");
+    // amdgpu; nvidia and i915 do not export the VRAM size in sysfs
+    const std::string vram_total = read_drm_by_path(device_path + "mem_info_vram_total");
+    if (!vram_total.empty()) {
+      gpu._memory_Bytes = std::strtoll(vram_total.c_str(), nullptr, 10);
+    }
+    gpu._bars = read_pci_bars(device_path);
+    gpu._resizable_bar = is_resizable_bar_active(gpu._bars, gpu._memory_Bytes);
+    // multi GPU machines mostly have several cards of the same model
+    auto same = std::find_if(gpus.begin(), gpus.end(), [&gpu](const GPU& g) {
+      return g._vendor_id == gpu._vendor_id && g._device_id == gpu._device_id;
+    });
+    if (same != gpus.end()) {
+      gpu._vendor = same->_vendor;
+      gpu._name = same->_name;
+    } else {
+      if (!pci) {
+        pci = PCI::getMapper();
+      }
+      const PCIVendor& vendor = (*pci)[gpu._vendor_id];
+      const PCIDevice& pci_device = vendor[gpu._device_id];
+      gpu._vendor = vendor.vendor_name_c_str();
+      gpu._name = pci_device.device_name_c_str();
+    }
     gpus.push_back(std::move(gpu));
-    id++;
   }
 #ifdef USE_OCL
-  auto cl_gpus = mcl::DeviceManager::get_list<mcl::Filter::GPU>();
-  for (auto& gpu : gpus) {
-    for (auto* cl_gpu : cl_gpus) {
-      if (cl_gpu->name().find(gpu._device_id)) {
-        gpu._driverVersion = cl_gpu->driver_version();
-        gpu._frequency_MHz = static_cast<int64_t>(cl_gpu->clock_frequency_MHz());
-        gpu._num_cores = static_cast<int>(cl_gpu->cores());
-        gpu._memory_Bytes = static_cast<int64_t>(cl_gpu->memory_Bytes());
+  const std::shared_future<std::vector<OpenCLGPU>>& cl_query = opencl_gpus();
+  if (!gpus.empty() && cl_query.wait_for(std::chrono::milliseconds(opencl_timeout_ms().load())) ==
+                           std::future_status::ready) {
+    for (auto& gpu : gpus) {
+      for (const auto& cl_gpu : cl_query.get()) {
+        if (cl_gpu.pci_address != gpu._pci_address) {
+          continue;
+        }
+        gpu._driverVersion = cl_gpu.driver_version;
+        if (cl_gpu.frequency_MHz > 0) {
+          gpu._frequency_MHz = cl_gpu.frequency_MHz;
+        }
+        gpu._num_cores = cl_gpu.num_cores;
+        // the global memory of OpenCL may be smaller than the VRAM, sysfs is exact where available
+        if (gpu._memory_Bytes <= 0) {
+          gpu._memory_Bytes = cl_gpu.memory_Bytes;
+        }
+        break;
       }
     }
   }
@@ -96,6 +402,314 @@ std::vector<GPU> getAllGPUs() {
   return gpus;
 }
 
+// _____________________________________________________________________________________________________________________
+int open_gpu_file(const std::string& path) { return open(path.c_str(), O_RDONLY | O_CLOEXEC); }
+
+// _____________________________________________________________________________________________________________________
+int64_t read_gpu_value(int fd) {
+  // sysfs attributes are regenerated on every read at offset 0
+  if (fd < 0) {
+    return -1;
+  }
+  char buffer[32];
+  ssize_t size = pread(fd, buffer, sizeof(buffer) - 1, 0);
+  if (size <= 0) {
+    return -1;
+  }
+  buffer[size] = '\0';
+  char* end = nullptr;
+  long long value = std::strtoll(buffer, &end, 10);
+  return end == buffer ? -1 : static_cast<int64_t>(value);
+}
+
+// _____________________________________________________________________________________________________________________
+GPUSampler::GPUSampler(const std::string& sysfs_root) {
+  for (const auto& device : scan_drm_devices(sysfs_root)) {
+    const std::string device_path(device.node_path + "device/");
+    Files files;
+    GPUSample sample;
+    sample.id = device.card;
+    // amdgpu
+    files.busy = open_gpu_file(device_path + "gpu_busy_percent");
+    files.vram_used = open_gpu_file(device_path + "mem_info_vram_used");
+    // the total does not change
+    int vram_total = open_gpu_file(device_path + "mem_info_vram_total");
+    sample.vram_total_Bytes = read_gpu_value(vram_total);
+    if (vram_total >= 0) {
+      close(vram_total);
+    }
+    // i915 (on the card node)
+    files.frequency = open_gpu_file(device.node_path + "gt_act_freq_mhz");
+    if (files.frequency < 0) {
+      files.frequency = open_gpu_file(device.node_path + "gt_cur_freq_mhz");
+    }
+    std::vector<std::string> hwmons = filesystem::getDirectoryEntries(device_path + "hwmon");
+    if (!hwmons.empty()) {
+      std::sort(hwmons.begin(), hwmons.end());
+      const std::string hwmon_path(device_path + "hwmon/" + hwmons[0] + '/');
+      if (files.frequency < 0) {
+        // amdgpu: shader clock
+        files.frequency = open_gpu_file(hwmon_path + "freq1_input");
+        files.frequency_Hz = files.frequency >= 0;
+      }
+      files.power = open_gpu_file(hwmon_path + "power1_average");
+      if (files.power < 0) {
+        files.power = open_gpu_file(hwmon_path + "power1_input");
+      }
+      files.temperature = open_gpu_file(hwmon_path + "temp1_input");
+      for (int i = 0; i < GPUSample::max_fans; ++i) {
+        files.fans[i] = open_gpu_file(hwmon_path + "fan" + std::to_string(i + 1) + "_input");
+      }
+    }
+    _files.push_back(files);
+    _samples.push_back(sample);
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+GPUSampler::~GPUSampler() {
+  for (const auto& files : _files) {
+    for (int fd : {files.busy, files.vram_used, files.frequency, files.power, files.temperature}) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+    for (int fd : files.fans) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+const std::vector<GPUSample>& GPUSampler::sample() {
+  for (size_t i = 0; i < _files.size(); ++i) {
+    const Files& files = _files[i];
+    GPUSample& sample = _samples[i];
+    sample.busy_percent = static_cast<int>(read_gpu_value(files.busy));
+    sample.vram_used_Bytes = read_gpu_value(files.vram_used);
+    sample.frequency_MHz = read_gpu_value(files.frequency);
+    if (files.frequency_Hz && sample.frequency_MHz > 0) {
+      sample.frequency_MHz /= 1000000;
+    }
+    // hwmon units: microwatt, millidegree Celsius
+    const int64_t power = read_gpu_value(files.power);
+    sample.power_W = power < 0 ? -1 : static_cast<double>(power) / 1e6;
+    const int64_t temperature = read_gpu_value(files.temperature);
+    sample.temperature_C = temperature < 0 ? -1 : static_cast<double>(temperature) / 1e3;
+    for (int f = 0; f < GPUSample::max_fans; ++f) {
+      sample.fan_RPM[f] = static_cast<int>(read_gpu_value(files.fans[f]));
+    }
+  }
+  return _samples;
+}
+
+struct DRMClient {
+  int pid{-1};
+  uint64_t client_id{0};
+  std::string pci_address;
+  std::string driver;
+  std::vector<GPUEngineUsage> engines;
+  int64_t resident_Bytes{-1};
+  int64_t memory_Bytes{-1};
+};
+
+// _____________________________________________________________________________________________________________________
+GPUEngineUsage& gpu_engine(std::vector<GPUEngineUsage>& engines, const std::string& name) {
+  for (auto& engine : engines) {
+    if (engine.name == name) {
+      return engine;
+    }
+  }
+  engines.emplace_back();
+  engines.back().name = name;
+  return engines.back();
+}
+
+// _____________________________________________________________________________________________________________________
+bool parse_drm_fdinfo(const std::string& path, DRMClient& client) {
+  // "drm-engine-gfx:\t123456 ns", "drm-memory-vram:\t1024 KiB", "drm-pdev:\t0000:03:00.0", ...
+  std::ifstream file(path);
+  std::string line;
+  bool has_client_id = false;
+  while (std::getline(file, line)) {
+    if (line.compare(0, 4, "drm-") != 0) {
+      continue;
+    }
+    const size_t colon = line.find(':');
+    if (colon == std::string::npos) {
+      continue;
+    }
+    const std::string key = line.substr(4, colon - 4);
+    size_t begin = line.find_first_not_of(" \t", colon + 1);
+    const std::string value = begin == std::string::npos ? "" : line.substr(begin);
+    char* unit = nullptr;
+    const uint64_t number = std::strtoull(value.c_str(), &unit, 10);
+    if (key == "driver") {
+      client.driver = value;
+    } else if (key == "pdev") {
+      client.pci_address = value;
+    } else if (key == "client-id") {
+      client.client_id = number;
+      has_client_id = true;
+    } else if (key.compare(0, 16, "engine-capacity-") == 0) {
+      gpu_engine(client.engines, key.substr(16)).capacity = static_cast<int>(std::max<uint64_t>(1, number));
+    } else if (key.compare(0, 7, "engine-") == 0) {
+      gpu_engine(client.engines, key.substr(7)).busy_ns = number;
+    } else if (key.compare(0, 9, "resident-") == 0 || key.compare(0, 7, "memory-") == 0) {
+      while (*unit == ' ') {
+        ++unit;
+      }
+      int64_t bytes = static_cast<int64_t>(number);
+      if (std::strncmp(unit, "KiB", 3) == 0) {
+        bytes *= 1024;
+      } else if (std::strncmp(unit, "MiB", 3) == 0) {
+        bytes *= 1024 * 1024;
+      } else if (std::strncmp(unit, "GiB", 3) == 0) {
+        bytes *= 1024 * 1024 * 1024;
+      }
+      int64_t& sum = key[0] == 'r' ? client.resident_Bytes : client.memory_Bytes;
+      sum = std::max<int64_t>(sum, 0) + bytes;
+    }
+  }
+  return has_client_id;
+}
+
+// _____________________________________________________________________________________________________________________
+void scan_drm_clients(const std::string& proc_root, int pid, std::vector<DRMClient>& clients) {
+  const std::string pid_path(proc_root + '/' + std::to_string(pid) + '/');
+  char target[PATH_MAX];
+  for (const auto& fd : filesystem::getDirectoryEntries(pid_path + "fd")) {
+    // only DRM nodes have drm-* keys: the link is much cheaper to read than the fdinfo
+    const ssize_t size = readlink((pid_path + "fd/" + fd).c_str(), target, sizeof(target));
+    if (size < 9 || std::strncmp(target, "/dev/dri/", 9) != 0) {
+      continue;
+    }
+    DRMClient client;
+    client.pid = pid;
+    if (parse_drm_fdinfo(pid_path + "fdinfo/" + fd, client)) {
+      clients.push_back(std::move(client));
+    }
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<GPUProcess> getGPUProcesses(const std::string& proc_root, int threads) {
+  std::vector<int> pids;
+  for (const auto& entry : filesystem::getDirectoryEntries(proc_root)) {
+    if (!entry.empty() && entry.find_first_not_of("0123456789") == std::string::npos) {
+      pids.push_back(std::atoi(entry.c_str()));
+    }
+  }
+  if (threads <= 0) {
+    threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  }
+  threads = static_cast<int>(std::min<size_t>(static_cast<size_t>(threads), pids.size() / 64 + 1));
+  std::vector<std::vector<DRMClient>> found(static_cast<size_t>(threads));
+  auto scan = [&proc_root, &pids, &found, threads](int worker) {
+    for (size_t i = static_cast<size_t>(worker); i < pids.size(); i += static_cast<size_t>(threads)) {
+      scan_drm_clients(proc_root, pids[i], found[static_cast<size_t>(worker)]);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (int worker = 1; worker < threads; ++worker) {
+    workers.emplace_back(scan, worker);
+  }
+  scan(0);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  std::vector<DRMClient> clients;
+  for (auto& part : found) {
+    std::move(part.begin(), part.end(), std::back_inserter(clients));
+  }
+  std::sort(clients.begin(), clients.end(), [](const DRMClient& a, const DRMClient& b) {
+    if (a.pid != b.pid) {
+      return a.pid < b.pid;
+    }
+    return a.pci_address != b.pci_address ? a.pci_address < b.pci_address : a.client_id < b.client_id;
+  });
+  std::vector<GPUProcess> processes;
+  for (size_t i = 0; i < clients.size(); ++i) {
+    const DRMClient& client = clients[i];
+    // the same client in several fds or processes: keep the first
+    bool seen = false;
+    for (const auto& process : processes) {
+      if (process.pci_address == client.pci_address &&
+          std::find(process.client_ids.begin(), process.client_ids.end(), client.client_id) !=
+              process.client_ids.end()) {
+        seen = true;
+        break;
+      }
+    }
+    if (seen) {
+      continue;
+    }
+    if (processes.empty() || processes.back().pid != client.pid || processes.back().pci_address != client.pci_address) {
+      processes.emplace_back();
+      processes.back().pid = client.pid;
+      processes.back().pci_address = client.pci_address;
+      processes.back().driver = client.driver;
+      processes.back().name = read_drm_by_path(proc_root + '/' + std::to_string(client.pid) + "/comm");
+    }
+    GPUProcess& process = processes.back();
+    process.client_ids.push_back(client.client_id);
+    for (const auto& engine : client.engines) {
+      GPUEngineUsage& sum = gpu_engine(process.engines, engine.name);
+      sum.busy_ns += engine.busy_ns;
+      sum.capacity = engine.capacity;
+    }
+    process.memory_Bytes += std::max<int64_t>(0, client.resident_Bytes >= 0 ? client.resident_Bytes
+                                                                            : client.memory_Bytes);
+  }
+  return processes;
+}
+
+// _____________________________________________________________________________________________________________________
+int64_t gpu_process_clock_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// _____________________________________________________________________________________________________________________
+GPUProcessSampler::GPUProcessSampler(const std::string& proc_root, int threads)
+    : _proc_root(proc_root), _threads(threads), _previous(getGPUProcesses(proc_root, threads)),
+      _previous_ns(gpu_process_clock_ns()) {}
+
+// _____________________________________________________________________________________________________________________
+std::vector<GPUProcess> GPUProcessSampler::sample() {
+  std::vector<GPUProcess> processes = getGPUProcesses(_proc_root, _threads);
+  const int64_t now_ns = gpu_process_clock_ns();
+  const double interval_ns = static_cast<double>(std::max<int64_t>(1, now_ns - _previous_ns));
+  for (auto& process : processes) {
+    // processes that opened the GPU in the interval have no previous entry: all of their busy time is new
+    auto previous = std::find_if(_previous.begin(), _previous.end(), [&process](const GPUProcess& p) {
+      return p.pid == process.pid && p.pci_address == process.pci_address;
+    });
+    process.utilisation_percent = 0;
+    for (auto& engine : process.engines) {
+      uint64_t busy_before = 0;
+      if (previous != _previous.end()) {
+        for (const auto& before : previous->engines) {
+          if (before.name == engine.name) {
+            busy_before = before.busy_ns;
+          }
+        }
+      }
+      // a closed client lowers the sum: no utilisation can be derived for the interval
+      const uint64_t busy_ns = engine.busy_ns >= busy_before ? engine.busy_ns - busy_before : 0;
+      engine.utilisation_percent =
+          std::min(100.0, 100.0 * static_cast<double>(busy_ns) / (interval_ns * engine.capacity));
+      process.utilisation_percent = std::max(process.utilisation_percent, engine.utilisation_percent);
+    }
+  }
+  _previous = processes;
+  _previous_ns = now_ns;
+  return processes;
+}
+
 }  // namespace hwinfo
 
 #endif  // HWINFO_UNIX
\ No newline at end of file
@@ -0,0 +1,142 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "../platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../memory_pages.h"
+#include "../ram.h"
+#include "../utils/stringutils.h"
+#include "utils/filesystem.h"
+
+namespace hwinfo {
+
+// _____________________________________________________________________________________________________________________
+std::string read_mm_setting(const std::string& path) {
+  // "always [madvise] never" -> "madvise"; single values ("1", "4096") as they are
+  std::ifstream file(path);
+  std::string line;
+  if (!file || !std::getline(file, line)) {
+    return "";
+  }
+  const auto open = line.find('[');
+  const auto close = line.find(']', open);
+  if (open != std::string::npos && close != std::string::npos) {
+    return line.substr(open + 1, close - open - 1);
+  }
+  utils::strip(line);
+  return line;
+}
+
+// _____________________________________________________________________________________________________________________
+int64_t huge_page_directory_size(const std::string& entry) {
+  // "hugepages-2048kB", -1 for other entries
+  if (!utils::starts_with(entry, "hugepages-") || entry.size() < 13 || !std::isdigit(entry[10]) ||
+      entry.compare(entry.size() - 2, 2, "kB") != 0) {
+    return -1;
+  }
+  return std::strtoll(entry.c_str() + 10, nullptr, 10) * 1024;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<HugePagePool> read_huge_page_pools(const std::string& path) {
+  // path: directory with one hugepages-<size>kB directory per page size
+  std::vector<HugePagePool> pools;
+  for (const auto& entry : filesystem::getDirectoryEntries(path)) {
+    const int64_t page_size = huge_page_directory_size(entry);
+    if (page_size < 0) {
+      continue;
+    }
+    const std::string pool_path(path + entry + '/');
+    HugePagePool pool;
+    pool.page_size_Bytes = page_size;
+    pool.total = filesystem::get_specs_by_file_path(pool_path + "nr_hugepages");
+    pool.free = filesystem::get_specs_by_file_path(pool_path + "free_hugepages");
+    pool.surplus = filesystem::get_specs_by_file_path(pool_path + "surplus_hugepages");
+    pool.reserved = filesystem::get_specs_by_file_path(pool_path + "resv_hugepages");
+    pool.overcommit_limit = filesystem::get_specs_by_file_path(pool_path + "nr_overcommit_hugepages");
+    pools.push_back(pool);
+  }
+  std::sort(pools.begin(), pools.end(),
+            [](const HugePagePool& a, const HugePagePool& b) { return a.page_size_Bytes < b.page_size_Bytes; });
+  return pools;
+}
+
+// _____________________________________________________________________________________________________________________
+MemoryPages getMemoryPages(const std::string& sysfs_root, const std::string& proc_root) {
+  MemoryPages pages;
+  pages.base_page_size_Bytes = sysconf(_SC_PAGESIZE);
+  pages.page_sizes_Bytes.push_back(pages.base_page_size_Bytes);
+  pages.huge_pages = read_huge_page_pools(sysfs_root + "/kernel/mm/hugepages/");
+  for (const auto& pool : pages.huge_pages) {
+    pages.page_sizes_Bytes.push_back(pool.page_size_Bytes);
+  }
+
+  const std::string node_path(sysfs_root + "/devices/system/node/");
+  for (const auto& entry : filesystem::getDirectoryEntries(node_path)) {
+    if (!utils::starts_with(entry, "node") || entry.size() < 5 || !std::isdigit(entry[4])) {
+      continue;
+    }
+    NodeHugePages node;
+    node.node = std::atoi(entry.c_str() + 4);
+    node.pools = read_huge_page_pools(node_path + entry + "/hugepages/");
+    pages.nodes.push_back(std::move(node));
+  }
+  std::sort(pages.nodes.begin(), pages.nodes.end(),
+            [](const NodeHugePages& a, const NodeHugePages& b) { return a.node < b.node; });
+
+  const std::string thp_path(sysfs_root + "/kernel/mm/transparent_hugepage/");
+  TransparentHugePages& thp = pages.transparent_huge_pages;
+  thp.enabled = read_mm_setting(thp_path + "enabled");
+  thp.available = !thp.enabled.empty();
+  thp.defrag = read_mm_setting(thp_path + "defrag");
+  thp.shmem_enabled = read_mm_setting(thp_path + "shmem_enabled");
+  thp.page_size_Bytes = filesystem::get_specs_by_file_path(thp_path + "hpage_pmd_size");
+  for (const auto& entry : filesystem::getDirectoryEntries(thp_path)) {
+    const int64_t page_size = huge_page_directory_size(entry);
+    if (page_size < 0) {
+      continue;
+    }
+    TransparentHugePageSize size;
+    size.page_size_Bytes = page_size;
+    size.enabled = read_mm_setting(thp_path + entry + "/enabled");
+    size.shmem_enabled = read_mm_setting(thp_path + entry + "/shmem_enabled");
+    thp.sizes.push_back(size);
+  }
+  std::sort(thp.sizes.begin(), thp.sizes.end(), [](const TransparentHugePageSize& a, const TransparentHugePageSize& b) {
+    return a.page_size_Bytes < b.page_size_Bytes;
+  });
+
+  const std::string khugepaged_path(thp_path + "khugepaged/");
+  Khugepaged& khugepaged = pages.khugepaged;
+  khugepaged.defrag = filesystem::get_specs_by_file_path(khugepaged_path + "defrag") > 0;
+  khugepaged.pages_to_scan = filesystem::get_specs_by_file_path(khugepaged_path + "pages_to_scan");
+  khugepaged.scan_sleep_ms = filesystem::get_specs_by_file_path(khugepaged_path + "scan_sleep_millisecs");
+  khugepaged.alloc_sleep_ms = filesystem::get_specs_by_file_path(khugepaged_path + "alloc_sleep_millisecs");
+  khugepaged.max_ptes_none = filesystem::get_specs_by_file_path(khugepaged_path + "max_ptes_none");
+  khugepaged.max_ptes_swap = filesystem::get_specs_by_file_path(khugepaged_path + "max_ptes_swap");
+  khugepaged.max_ptes_shared = filesystem::get_specs_by_file_path(khugepaged_path + "max_ptes_shared");
+  khugepaged.full_scans = filesystem::get_specs_by_file_path(khugepaged_path + "full_scans");
+  khugepaged.pages_collapsed = filesystem::get_specs_by_file_path(khugepaged_path + "pages_collapsed");
+
+  const MemInfo mem_info = getMemInfo((proc_root + "/meminfo").c_str());
+  pages.anon_huge_pages_Bytes = mem_info.anon_huge_pages_Bytes;
+  pages.shmem_huge_pages_Bytes = mem_info.shmem_huge_pages_Bytes;
+  pages.file_huge_pages_Bytes = mem_info.file_huge_pages_Bytes;
+  return pages;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
@@ -0,0 +1,147 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "../platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../PCIMapper.h"
+#include "../pci.h"
+#include "utils/filesystem.h"
+
+namespace hwinfo {
+
+// _____________________________________________________________________________________________________________________
+std::string read_pci_attribute(const std::string& device_path, const char* attribute) {
+  std::ifstream file(device_path + attribute);
+  std::string value;
+  if (file) {
+    std::getline(file, value);
+  }
+  return value;
+}
+
+// _____________________________________________________________________________________________________________________
+int64_t parse_pci_number(const std::string& value, int base, int64_t fallback) {
+  if (value.empty()) {
+    return fallback;
+  }
+  char* end = nullptr;
+  long long number = std::strtoll(value.c_str(), &end, base);
+  return end == value.c_str() ? fallback : static_cast<int64_t>(number);
+}
+
+// _____________________________________________________________________________________________________________________
+double parse_link_speed_GTps(const std::string& value) {
+  // "8.0 GT/s PCIe", "2.5 GT/s", "Unknown"
+  char* end = nullptr;
+  double speed = std::strtod(value.c_str(), &end);
+  return (end == value.c_str() || speed <= 0) ? -1 : speed;
+}
+
+// _____________________________________________________________________________________________________________________
+int count_msix_vectors(const std::string& device_path) {
+  // one file per allocated MSI/MSI-X vector, containing "msi" or "msix"
+  const std::string msi_path(device_path + "msi_irqs/");
+  int count = 0;
+  for (const auto& irq : filesystem::getDirectoryEntries(msi_path)) {
+    std::ifstream file(msi_path + irq);
+    std::string mode;
+    if (file >> mode && mode == "msix") {
+      count++;
+    }
+  }
+  return count;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<PCIBusDevice> getPCIDevicesOfClass(uint32_t class_code, uint32_t class_mask,
+                                               const std::string& sysfs_root) {
+  std::vector<PCIBusDevice> devices;
+  const std::string bus_path(sysfs_root + "/bus/pci/devices/");
+  std::shared_ptr<const PCIMapper> pci;
+  for (const auto& address : filesystem::getDirectoryEntries(bus_path)) {
+    PCIBusDevice device;
+    unsigned domain = 0, bus = 0, slot = 0, function = 0;
+    if (std::sscanf(address.c_str(), "%x:%x:%x.%x", &domain, &bus, &slot, &function) != 4) {
+      continue;
+    }
+    const std::string path(bus_path + address + '/');
+    device._class_code = static_cast<uint32_t>(parse_pci_number(read_pci_attribute(path, "class"), 16, 0));
+    if ((device._class_code & class_mask) != (class_code & class_mask)) {
+      continue;
+    }
+    device._address = address;
+    device._domain = static_cast<int>(domain);
+    device._bus = static_cast<int>(bus);
+    device._device = static_cast<int>(slot);
+    device._function = static_cast<int>(function);
+    device._vendor_id = static_cast<uint16_t>(parse_pci_number(read_pci_attribute(path, "vendor"), 16, 0));
+    device._device_id = static_cast<uint16_t>(parse_pci_number(read_pci_attribute(path, "device"), 16, 0));
+    device._subsystem_vendor_id =
+        static_cast<uint16_t>(parse_pci_number(read_pci_attribute(path, "subsystem_vendor"), 16, 0));
+    device._subsystem_device_id =
+        static_cast<uint16_t>(parse_pci_number(read_pci_attribute(path, "subsystem_device"), 16, 0));
+
+    char driver[256];
+    ssize_t length = readlink((path + "driver").c_str(), driver, sizeof(driver) - 1);
+    if (length > 0) {
+      driver[length] = '\0';
+      const char* slash = std::strrchr(driver, '/');
+      device._driver = slash == nullptr ? driver : slash + 1;
+    }
+    device._numa_node = static_cast<int>(parse_pci_number(read_pci_attribute(path, "numa_node"), 10, -1));
+    device._current_link_speed_GTps = parse_link_speed_GTps(read_pci_attribute(path, "current_link_speed"));
+    device._max_link_speed_GTps = parse_link_speed_GTps(read_pci_attribute(path, "max_link_speed"));
+    device._current_link_width =
+        static_cast<int>(parse_pci_number(read_pci_attribute(path, "current_link_width"), 10, -1));
+    device._max_link_width = static_cast<int>(parse_pci_number(read_pci_attribute(path, "max_link_width"), 10, -1));
+    device._msix_vectors = count_msix_vectors(path);
+
+    if (!pci) {
+      pci = PCI::getMapper();
+    }
+    const PCINames names = pci->resolve(
+        {device._vendor_id, device._device_id, device._subsystem_vendor_id, device._subsystem_device_id});
+    if (names.vendor != nullptr) {
+      device._vendor = names.vendor;
+    }
+    if (names.device != nullptr) {
+      device._name = names.device;
+    }
+    if (names.subsystem != nullptr) {
+      device._subsystem_name = names.subsystem;
+    }
+    const PCIClassNames class_names = pci->resolve_class(device._class_code);
+    if (class_names.base_class != nullptr) {
+      device._class_name = class_names.base_class;
+    }
+    if (class_names.subclass != nullptr) {
+      device._subclass_name = class_names.subclass;
+    }
+    devices.push_back(std::move(device));
+  }
+  std::sort(devices.begin(), devices.end(),
+            [](const PCIBusDevice& a, const PCIBusDevice& b) { return a.address() < b.address(); });
+  return devices;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<PCIBusDevice> getAllPCIDevices(const std::string& sysfs_root) {
+  return getPCIDevicesOfClass(0, 0, sysfs_root);
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
@@ -0,0 +1,130 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "../platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "../pressure.h"
+
+namespace hwinfo {
+
+// _____________________________________________________________________________________________________________________
+const char* pressure_resource_name(PressureResource resource) {
+  switch (resource) {
+    case PressureResource::CPU:
+      return "cpu";
+    case PressureResource::Memory:
+      return "memory";
+    case PressureResource::IO:
+      return "io";
+  }
+  return "";
+}
+
+// _____________________________________________________________________________________________________________________
+void parse_pressure_line(const char* line, PressureStall& stall) {
+  // "avg10=0.12 avg60=0.04 avg300=0.01 total=123456"
+  const char* avg10 = std::strstr(line, "avg10=");
+  const char* avg60 = std::strstr(line, "avg60=");
+  const char* avg300 = std::strstr(line, "avg300=");
+  const char* total = std::strstr(line, "total=");
+  if (avg10 == nullptr || avg60 == nullptr || avg300 == nullptr || total == nullptr) {
+    return;
+  }
+  stall.avg10 = std::strtod(avg10 + 6, nullptr);
+  stall.avg60 = std::strtod(avg60 + 6, nullptr);
+  stall.avg300 = std::strtod(avg300 + 7, nullptr);
+  stall.total_us = std::strtoull(total + 6, nullptr, 10);
+}
+
+// _____________________________________________________________________________________________________________________
+Pressure read_pressure(const std::string& path) {
+  Pressure pressure;
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return pressure;
+  }
+  char buffer[256];
+  const ssize_t size = read(fd, buffer, sizeof(buffer) - 1);
+  close(fd);
+  if (size <= 0) {
+    return pressure;
+  }
+  buffer[size] = '\0';
+  const char* some = std::strstr(buffer, "some ");
+  if (some == nullptr) {
+    return pressure;
+  }
+  pressure.available = true;
+  parse_pressure_line(some, pressure.some);
+  const char* full = std::strstr(buffer, "full ");
+  if (full != nullptr) {
+    parse_pressure_line(full, pressure.full);
+  }
+  return pressure;
+}
+
+// _____________________________________________________________________________________________________________________
+Pressure getPressure(PressureResource resource, const std::string& proc_root) {
+  return read_pressure(proc_root + "/pressure/" + pressure_resource_name(resource));
+}
+
+// _____________________________________________________________________________________________________________________
+Pressure getCgroupPressure(PressureResource resource, const std::string& cgroup_path) {
+  return read_pressure(cgroup_path + '/' + pressure_resource_name(resource) + ".pressure");
+}
+
+// _____________________________________________________________________________________________________________________
+PressureTrigger::PressureTrigger(const std::string& pressure_file, bool full, int64_t threshold_us,
+                                 int64_t window_us) {
+  _fd = open(pressure_file.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (_fd < 0) {
+    throw std::runtime_error("ERROR: Could not open '" + pressure_file + "' (" + std::strerror(errno) + ").\n");
+  }
+  // "some 150000 1000000": the kernel expects the terminating null byte as part of the write
+  const std::string trigger =
+      std::string(full ? "full " : "some ") + std::to_string(threshold_us) + ' ' + std::to_string(window_us);
+  if (write(_fd, trigger.c_str(), trigger.size() + 1) < 0) {
+    const std::string error(std::strerror(errno));
+    close(_fd);
+    _fd = -1;
+    throw std::runtime_error("ERROR: Could not register trigger '" + trigger + "' on '" + pressure_file + "' (" +
+                             error + ").\n");
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+PressureTrigger::~PressureTrigger() {
+  if (_fd >= 0) {
+    close(_fd);
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+bool PressureTrigger::wait(int timeout_ms) const {
+  pollfd event{_fd, POLLPRI, 0};
+  int ready = 0;
+  do {
+    ready = poll(&event, 1, timeout_ms);
+  } while (ready < 0 && errno == EINTR);
+  if (ready < 0 || (event.revents & POLLERR) != 0) {
+    throw std::runtime_error("ERROR: Pressure trigger failed, the monitored cgroup may have been removed.\n");
+  }
+  return ready > 0 && (event.revents & POLLPRI) != 0;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
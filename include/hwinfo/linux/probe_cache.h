@@ -0,0 +1,112 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "../platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <sys/utsname.h>
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <string>
+
+#include "../probe_cache.h"
+#include "../smbios.h"
+#include "../utils/stringutils.h"
+#include "utils/filesystem.h"
+
+namespace hwinfo {
+
+// _____________________________________________________________________________________________________________________
+std::string getHardwareFingerprintSource() {
+  std::string source;
+  std::string model;
+  std::string microcode;
+  std::set<std::string> packages;
+  std::set<std::string> cores;
+  int logical_cores = 0;
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  std::string physical_id;
+  while (std::getline(cpuinfo, line)) {
+    auto colon = line.find(':');
+    if (colon == std::string::npos) {
+      continue;
+    }
+    std::string name(line.substr(0, colon));
+    std::string value(line.substr(colon + 1));
+    utils::strip(name);
+    utils::strip(value);
+    if (name == "processor") {
+      logical_cores++;
+    } else if ((name == "model name" || name == "Hardware" || name == "CPU part") && model.empty()) {
+      model = value;
+    } else if (name == "microcode" && microcode.empty()) {
+      microcode = value;
+    } else if (name == "physical id") {
+      physical_id = value;
+      packages.insert(value);
+    } else if (name == "core id") {
+      cores.insert(physical_id + ":" + value);
+    }
+  }
+  source += "cpu.model=" + model + '\n';
+  source += "cpu.microcode=" + microcode + '\n';
+  source += "cpu.packages=" + std::to_string(packages.size()) + '\n';
+  source += "cpu.cores=" + std::to_string(cores.size()) + '\n';
+  source += "cpu.threads=" + std::to_string(logical_cores) + '\n';
+
+  // memory: total size (rounded to GiB, the kernel reserves slightly different amounts between boots) and NUMA nodes
+  std::ifstream meminfo("/proc/meminfo");
+  long long total_kB = 0;
+  while (std::getline(meminfo, line)) {
+    if (utils::starts_with(line, "MemTotal:")) {
+      total_kB = std::strtoll(line.c_str() + 9, nullptr, 10);
+      break;
+    }
+  }
+  source += "memory.total_GiB=" + std::to_string((total_kB + 512 * 1024) / (1024 * 1024)) + '\n';
+  int nodes = 0;
+  for (const auto& entry : filesystem::getDirectoryEntries("/sys/devices/system/node/")) {
+    if (utils::starts_with(entry, "node") && entry.size() > 4 && std::isdigit(entry[4])) {
+      nodes++;
+    }
+  }
+  source += "memory.numa_nodes=" + std::to_string(nodes) + '\n';
+  // populated modules as "<locator>:<MiB>@<MT/s>r<rank>", to notice a module swap or a changed speed that leaves the
+  // total size unchanged. Empty if the SMBIOS table is not readable (not root): such a process gets a different
+  // fingerprint than a root process on the same machine, which only costs a re-measurement.
+  std::string dimms;
+  for (const auto& device : getSMBIOSMemory().devices) {
+    if (device.populated()) {
+      dimms += (dimms.empty() ? "" : ",") + device.locator + ':' + std::to_string(device.size_Bytes / (1024 * 1024)) +
+               '@' + std::to_string(device.configured_speed_MTps) + 'r' + std::to_string(device.rank);
+    }
+  }
+  source += "memory.dimms=" + dimms + '\n';
+
+  utsname info{};
+  source += "kernel=" + std::string(uname(&info) == 0 ? info.release : "") + '\n';
+  return source;
+}
+
+// _____________________________________________________________________________________________________________________
+std::string getHardwareFingerprint() {
+  // FNV-1a, 64 bit
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (unsigned char c : getHardwareFingerprintSource()) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  char hex[17];
+  std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+  return hex;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
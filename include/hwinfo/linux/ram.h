@@ -6,72 +6,187 @@
 #ifdef HWINFO_UNIX
 
 #include "../ram.h"
+#include "../smbios.h"
 #include "../utils/stringutils.h"
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <limits>
+#include <random>
 #include <string>
 #include <vector>
 
 namespace hwinfo {
 
-// _____________________________________________________________________________________________________________________
-struct MemInfo {
-  int64_t total{-1};
-  int64_t free{-1};
-  int64_t available{-1};
+struct MemInfoKey {
+  const char* name;
+  int64_t MemInfo::*field;
 };
 
-void get_from_sysconf(MemInfo& mi) {
-  int64_t pages = sysconf(_SC_PHYS_PAGES);
-  int64_t available_pages = sysconf(_SC_AVPHYS_PAGES);
-  int64_t page_size = sysconf(_SC_PAGESIZE);
-  if (pages > 0 && page_size > 0) {
-    mi.total = pages * page_size;
-  }
-  if (available_pages > 0 && page_size > 0) {
-    mi.available = available_pages * page_size;
-  }
-}
+// in the order of /proc/meminfo, so that the next line is found at the next position of the table
+static constexpr MemInfoKey meminfo_keys[] = {
+    {"MemTotal", &MemInfo::total_Bytes},
+    {"MemFree", &MemInfo::free_Bytes},
+    {"MemAvailable", &MemInfo::available_Bytes},
+    {"Buffers", &MemInfo::buffers_Bytes},
+    {"Cached", &MemInfo::cached_Bytes},
+    {"SwapCached", &MemInfo::swap_cached_Bytes},
+    {"Active", &MemInfo::active_Bytes},
+    {"Inactive", &MemInfo::inactive_Bytes},
+    {"Active(anon)", &MemInfo::active_anon_Bytes},
+    {"Inactive(anon)", &MemInfo::inactive_anon_Bytes},
+    {"Active(file)", &MemInfo::active_file_Bytes},
+    {"Inactive(file)", &MemInfo::inactive_file_Bytes},
+    {"Unevictable", &MemInfo::unevictable_Bytes},
+    {"Mlocked", &MemInfo::mlocked_Bytes},
+    {"HighTotal", &MemInfo::high_total_Bytes},
+    {"HighFree", &MemInfo::high_free_Bytes},
+    {"LowTotal", &MemInfo::low_total_Bytes},
+    {"LowFree", &MemInfo::low_free_Bytes},
+    {"MmapCopy", &MemInfo::mmap_copy_Bytes},
+    {"SwapTotal", &MemInfo::swap_total_Bytes},
+    {"SwapFree", &MemInfo::swap_free_Bytes},
+    {"Zswap", &MemInfo::zswap_Bytes},
+    {"Zswapped", &MemInfo::zswapped_Bytes},
+    {"Dirty", &MemInfo::dirty_Bytes},
+    {"Writeback", &MemInfo::writeback_Bytes},
+    {"AnonPages", &MemInfo::anon_pages_Bytes},
+    {"Mapped", &MemInfo::mapped_Bytes},
+    {"Shmem", &MemInfo::shmem_Bytes},
+    {"KReclaimable", &MemInfo::kreclaimable_Bytes},
+    {"Slab", &MemInfo::slab_Bytes},
+    {"SReclaimable", &MemInfo::sreclaimable_Bytes},
+    {"SUnreclaim", &MemInfo::sunreclaim_Bytes},
+    {"KernelStack", &MemInfo::kernel_stack_Bytes},
+    {"ShadowCallStack", &MemInfo::shadow_call_stack_Bytes},
+    {"PageTables", &MemInfo::page_tables_Bytes},
+    {"SecPageTables", &MemInfo::sec_page_tables_Bytes},
+    {"NFS_Unstable", &MemInfo::nfs_unstable_Bytes},
+    {"Bounce", &MemInfo::bounce_Bytes},
+    {"WritebackTmp", &MemInfo::writeback_tmp_Bytes},
+    {"CommitLimit", &MemInfo::commit_limit_Bytes},
+    {"Committed_AS", &MemInfo::committed_as_Bytes},
+    {"VmallocTotal", &MemInfo::vmalloc_total_Bytes},
+    {"VmallocUsed", &MemInfo::vmalloc_used_Bytes},
+    {"VmallocChunk", &MemInfo::vmalloc_chunk_Bytes},
+    {"Percpu", &MemInfo::percpu_Bytes},
+    {"HardwareCorrupted", &MemInfo::hardware_corrupted_Bytes},
+    {"AnonHugePages", &MemInfo::anon_huge_pages_Bytes},
+    {"ShmemHugePages", &MemInfo::shmem_huge_pages_Bytes},
+    {"ShmemPmdMapped", &MemInfo::shmem_pmd_mapped_Bytes},
+    {"FileHugePages", &MemInfo::file_huge_pages_Bytes},
+    {"FilePmdMapped", &MemInfo::file_pmd_mapped_Bytes},
+    {"CmaTotal", &MemInfo::cma_total_Bytes},
+    {"CmaFree", &MemInfo::cma_free_Bytes},
+    {"Unaccepted", &MemInfo::unaccepted_Bytes},
+    {"Balloon", &MemInfo::balloon_Bytes},
+    {"HugePages_Total", &MemInfo::hugepages_total},
+    {"HugePages_Free", &MemInfo::hugepages_free},
+    {"HugePages_Rsvd", &MemInfo::hugepages_reserved},
+    {"HugePages_Surp", &MemInfo::hugepages_surplus},
+    {"Hugepagesize", &MemInfo::hugepage_size_Bytes},
+    {"Hugetlb", &MemInfo::hugetlb_Bytes},
+    {"DirectMap4k", &MemInfo::direct_map_4k_Bytes},
+    {"DirectMap64k", &MemInfo::direct_map_64k_Bytes},
+    {"DirectMap1M", &MemInfo::direct_map_1M_Bytes},
+    {"DirectMap2M", &MemInfo::direct_map_2M_Bytes},
+    {"DirectMap4M", &MemInfo::direct_map_4M_Bytes},
+    {"DirectMap1G", &MemInfo::direct_map_1G_Bytes},
+    {"DirectMap2G", &MemInfo::direct_map_2G_Bytes},
+};
 
-void set_value(std::string& line, int64_t* dst) {
-  auto split_line = utils::split(line, ":");
-  if (split_line.size() == 2) {
-    auto& value = split_line[1];
-    utils::strip(value);
-    auto space = value.find(' ');
-    if (space != std::string::npos) {
-      auto a = std::string(value.begin(), value.begin() + static_cast<int64_t>(space));
-      *dst = (std::stoll(a) * 1024);
-      int i = 0;
-    }
+// _____________________________________________________________________________________________________________________
+const char* match_meminfo_key(const char* line, const char* key) {
+  // pointer behind "<key>:" if line starts with it, nullptr otherwise
+  while (*key != '\0' && *line == *key) {
+    ++line;
+    ++key;
   }
+  return (*key == '\0' && *line == ':') ? line + 1 : nullptr;
 }
 
-MemInfo parse_meminfo() {
-  MemInfo mi;
-  std::ifstream f_meminfo("/proc/meminfo");
-  if (!f_meminfo) {
-    get_from_sysconf(mi);
-  } else {
-    while (mi.total == -1 || mi.available == -1 || mi.free == -1) {
-      std::string line;
-      if (!std::getline(f_meminfo, line)) {
-        if (mi.total == -1 || mi.available == -1) {
-          get_from_sysconf(mi);
-        }
-        return mi;
+// _____________________________________________________________________________________________________________________
+void parse_meminfo(const char* begin, const char* end, MemInfo& info) {
+  const size_t num_keys = sizeof(meminfo_keys) / sizeof(meminfo_keys[0]);
+  size_t next_key = 0;
+  for (const char* line = begin; line < end;) {
+    const char* line_end = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+    if (line_end == nullptr) {
+      line_end = end;
+    }
+    // mostly a hit at the first try; keys of other kernel versions cost one pass over the table
+    const char* value = nullptr;
+    size_t key = next_key;
+    for (size_t tried = 0; tried < num_keys; ++tried, key = (key + 1) % num_keys) {
+      value = match_meminfo_key(line, meminfo_keys[key].name);
+      if (value != nullptr) {
+        break;
       }
-      if (utils::starts_with(line, "MemTotal")) {
-        set_value(line, &mi.total);
-      } else if (utils::starts_with(line, "MemFree")) {
-        set_value(line, &mi.free);
-      } else if (utils::starts_with(line, "MemAvailable")) {
-        set_value(line, &mi.available);
+    }
+    if (value != nullptr) {
+      while (value < line_end && *value == ' ') {
+        ++value;
       }
+      int64_t number = 0;
+      while (value < line_end && *value >= '0' && *value <= '9') {
+        number = number * 10 + (*value++ - '0');
+      }
+      if (value + 3 <= line_end && value[0] == ' ' && value[1] == 'k' && value[2] == 'B') {
+        number *= 1024;
+      }
+      info.*meminfo_keys[key].field = number;
+      next_key = (key + 1) % num_keys;
     }
+    line = line_end + 1;
   }
-  return mi;
+}
+
+// _____________________________________________________________________________________________________________________
+MemInfo read_meminfo(int fd) {
+  MemInfo info;
+  // about 1.5 KiB on current kernels
+  char buffer[8192];
+  const ssize_t size = fd < 0 ? -1 : pread(fd, buffer, sizeof(buffer), 0);
+  if (size > 0) {
+    parse_meminfo(buffer, buffer + size, info);
+  }
+  return info;
+}
+
+// _____________________________________________________________________________________________________________________
+MemInfo getMemInfo(const char* path) {
+  const int fd = open(path, O_RDONLY | O_CLOEXEC);
+  MemInfo info = read_meminfo(fd);
+  if (fd >= 0) {
+    close(fd);
+  }
+  return info;
+}
+
+// _____________________________________________________________________________________________________________________
+MemInfoSampler::MemInfoSampler(const char* path) : _fd(open(path, O_RDONLY | O_CLOEXEC)) {}
+
+// _____________________________________________________________________________________________________________________
+MemInfoSampler::~MemInfoSampler() {
+  if (_fd >= 0) {
+    close(_fd);
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+MemInfo MemInfoSampler::sample() const { return read_meminfo(_fd); }
+
+// _____________________________________________________________________________________________________________________
+const SMBIOSMemory& RAM::modules() const {
+  // the table does not change while the system runs; later RAM objects only read /proc/meminfo
+  static const SMBIOSMemory memory = getSMBIOSMemory();
+  return memory;
 }
 
 // _____________________________________________________________________________________________________________________
@@ -80,10 +195,203 @@ RAM::RAM() {
   _vendor = "<unknown>";
   _serialNumber = "<unknown>";
   _model = "<unknown>";
-  auto meminfo = parse_meminfo();
-  _total_Bytes = meminfo.total;
-  _free_Bytes = meminfo.free;
-  _available_Bytes = meminfo.available;
+  _mem_info = getMemInfo();
+  if (_mem_info.total_Bytes < 0) {
+    // no procfs (e.g. some sandboxes)
+    const int64_t page_size = sysconf(_SC_PAGESIZE);
+    const int64_t pages = sysconf(_SC_PHYS_PAGES);
+    const int64_t available_pages = sysconf(_SC_AVPHYS_PAGES);
+    if (pages > 0 && page_size > 0) {
+      _mem_info.total_Bytes = pages * page_size;
+    }
+    if (available_pages > 0 && page_size > 0) {
+      _mem_info.available_Bytes = available_pages * page_size;
+    }
+  }
+  _total_Bytes = _mem_info.total_Bytes;
+  _free_Bytes = _mem_info.free_Bytes;
+  _available_Bytes = _mem_info.available_Bytes;
+
+  for (const auto& device : modules().devices) {
+    if (!device.populated()) {
+      continue;
+    }
+    // like WIN32_PhysicalMemory: the first module stands for all of them
+    if (!device.manufacturer.empty()) {
+      _vendor = device.manufacturer;
+    }
+    _name = device.type;
+    if (!device.part_number.empty()) {
+      _model = device.part_number;
+    }
+    if (!device.serial_number.empty()) {
+      _serialNumber = device.serial_number;
+    }
+    _frequency = static_cast<int>(device.configured_speed_MTps > 0 ? device.configured_speed_MTps : device.speed_MTps);
+    break;
+  }
+}
+
+// =====================================================================================================================
+// Huge page probe
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+// _____________________________________________________________________________________________________________________
+/**
+ * Bytes of the mapping that contains address which are backed by transparent huge pages (AnonHugePages in
+ * /proc/self/smaps). Returns -1 if the mapping was not found.
+ */
+int64_t get_anon_huge_bytes(const void* address) {
+  std::ifstream smaps("/proc/self/smaps");
+  if (!smaps) {
+    return -1;
+  }
+  const auto target = reinterpret_cast<uintptr_t>(address);
+  bool in_mapping = false;
+  std::string line;
+  while (std::getline(smaps, line)) {
+    // mapping header lines look like "7f2c4a000000-7f2c8a000000 rw-p 00000000 00:00 0"
+    auto dash = line.find('-');
+    auto space = line.find(' ');
+    if (dash != std::string::npos && space != std::string::npos && dash < space && line.find(':') > space) {
+      if (in_mapping) {
+        return 0;
+      }
+      uintptr_t start = std::strtoull(line.c_str(), nullptr, 16);
+      uintptr_t end = std::strtoull(line.c_str() + dash + 1, nullptr, 16);
+      in_mapping = target >= start && target < end;
+      continue;
+    }
+    if (in_mapping && utils::starts_with(line, "AnonHugePages:")) {
+      return std::strtoll(line.c_str() + 14, nullptr, 10) * 1024;
+    }
+  }
+  return in_mapping ? 0 : -1;
+}
+
+// _____________________________________________________________________________________________________________________
+/**
+ * Link one node per 4K page (at a random cache line within the page) into a single random cycle and return the offset
+ * of the first node. Every node stores the offset of its successor, so that walking the cycle is a chain of dependent
+ * loads that the prefetchers cannot predict.
+ */
+size_t build_page_chase(char* buffer, int64_t buffer_Bytes) {
+  const size_t page = 4096;
+  const size_t line = 64;
+  const auto num_pages = static_cast<size_t>(buffer_Bytes) / page;
+  std::mt19937_64 rng(42);
+  std::vector<size_t> order(num_pages);
+  for (size_t i = 0; i < num_pages; ++i) {
+    order[i] = i * page + (rng() % (page / line)) * line;
+  }
+  // Sattolo's algorithm: a random permutation that is one single cycle
+  for (size_t i = num_pages - 1; i > 0; --i) {
+    std::swap(order[i], order[rng() % i]);
+  }
+  for (size_t i = 0; i < num_pages; ++i) {
+    *reinterpret_cast<size_t*>(buffer + order[i]) = order[(i + 1) % num_pages];
+  }
+  return order[0];
+}
+
+// _____________________________________________________________________________________________________________________
+/**
+ * Average time of one step of the page chase in ns (best of three runs of accesses steps).
+ */
+double time_page_chase(const char* buffer, size_t start, int64_t accesses) {
+  double best = std::numeric_limits<double>::max();
+  size_t position = start;
+  for (int run = 0; run < 3; ++run) {
+    auto begin = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < accesses; ++i) {
+      position = *reinterpret_cast<const size_t*>(buffer + position);
+    }
+    auto end = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double, std::nano>(end - begin).count());
+  }
+  // keep the chase alive
+  volatile size_t sink = position;
+  (void)sink;
+  return best / static_cast<double>(accesses);
+}
+
+// _____________________________________________________________________________________________________________________
+PageBackingMeasurement measure_page_backing(PageBacking backing, int64_t buffer_Bytes, int64_t accesses) {
+  PageBackingMeasurement measurement;
+  measurement.backing = backing;
+  const int64_t huge_2M = 2 * 1024 * 1024;
+  const int64_t huge_1G = 1024 * 1024 * 1024;
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  switch (backing) {
+    case PageBacking::Base:
+      measurement.page_size_Bytes = 4096;
+      break;
+    case PageBacking::TransparentHuge:
+      measurement.page_size_Bytes = huge_2M;
+      break;
+    case PageBacking::HugeTLB_2M:
+      measurement.page_size_Bytes = huge_2M;
+      flags |= MAP_HUGETLB | (21 << MAP_HUGE_SHIFT);
+      break;
+    case PageBacking::HugeTLB_1G:
+      measurement.page_size_Bytes = huge_1G;
+      flags |= MAP_HUGETLB | (30 << MAP_HUGE_SHIFT);
+      break;
+  }
+  // hugetlb mappings must be a multiple of the page size; THP needs 2M alignment, so we map one huge page more
+  const int64_t rounded = (buffer_Bytes + measurement.page_size_Bytes - 1) / measurement.page_size_Bytes *
+                          measurement.page_size_Bytes;
+  const int64_t mapped = backing == PageBacking::TransparentHuge ? rounded + huge_2M : rounded;
+  void* mapping = mmap(nullptr, static_cast<size_t>(mapped), PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (mapping == MAP_FAILED) {
+    return measurement;
+  }
+  char* buffer = static_cast<char*>(mapping);
+  if (backing == PageBacking::Base) {
+    // THP may be set to "always", make sure this really is the 4K baseline
+    madvise(buffer, static_cast<size_t>(mapped), MADV_NOHUGEPAGE);
+  } else if (backing == PageBacking::TransparentHuge) {
+    auto aligned = (reinterpret_cast<uintptr_t>(buffer) + huge_2M - 1) & ~static_cast<uintptr_t>(huge_2M - 1);
+    buffer = reinterpret_cast<char*>(aligned);
+    madvise(buffer, static_cast<size_t>(rounded), MADV_HUGEPAGE);
+  }
+  measurement.available = true;
+  // the chase covers buffer_Bytes in every backing, the rounding only serves the mapping. Building it populates the
+  // buffer (the page faults decide about THP).
+  const size_t start = build_page_chase(buffer, buffer_Bytes);
+  if (backing == PageBacking::TransparentHuge) {
+    // a fault in the last, partly used huge page maps all of it
+    measurement.huge_Bytes = std::min(buffer_Bytes, std::max<int64_t>(0, get_anon_huge_bytes(buffer)));
+  } else if (backing != PageBacking::Base) {
+    measurement.huge_Bytes = buffer_Bytes;
+  }
+  // one warm up pass over all pages, then the measurement
+  time_page_chase(buffer, start, buffer_Bytes / 4096);
+  measurement.access_ns = time_page_chase(buffer, start, accesses);
+  munmap(mapping, static_cast<size_t>(mapped));
+  return measurement;
+}
+
+// _____________________________________________________________________________________________________________________
+HugePageProbe probeHugePages(int64_t buffer_Bytes, int64_t accesses) {
+  HugePageProbe probe;
+  probe.buffer_Bytes = std::max<int64_t>(buffer_Bytes, 4096);
+  const PageBacking backings[] = {PageBacking::Base, PageBacking::TransparentHuge, PageBacking::HugeTLB_2M,
+                                  PageBacking::HugeTLB_1G};
+  for (auto backing : backings) {
+    probe.measurements.push_back(measure_page_backing(backing, probe.buffer_Bytes, std::max<int64_t>(accesses, 1)));
+  }
+  const double base_ns = probe.measurements[0].access_ns;
+  for (auto& measurement : probe.measurements) {
+    if (measurement.available && base_ns > 0) {
+      measurement.saved_ns = base_ns - measurement.access_ns;
+    }
+  }
+  probe.thp_granted = probe.measurements[1].huge_Bytes > 0;
+  return probe;
 }
 
 }  // namespace hwinfo
@@ -0,0 +1,41 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "../platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../smbios.h"
+
+namespace hwinfo {
+
+// _____________________________________________________________________________________________________________________
+std::vector<uint8_t> read_dmi_file(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return {};
+  }
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// _____________________________________________________________________________________________________________________
+SMBIOSMemory getSMBIOSMemory(const std::string& sysfs_root) {
+  const std::string tables_path(sysfs_root + "/firmware/dmi/tables/");
+  const std::vector<uint8_t> table = read_dmi_file(tables_path + "DMI");
+  if (table.empty()) {
+    return SMBIOSMemory();
+  }
+  const std::vector<uint8_t> entry_point = read_dmi_file(tables_path + "smbios_entry_point");
+  return parseSMBIOSMemory(table.data(), table.size(), entry_point.empty() ? nullptr : entry_point.data(),
+                           entry_point.size());
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
@@ -0,0 +1,122 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "../platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../USBMapper.h"
+#include "../usb.h"
+#include "utils/filesystem.h"
+
+namespace hwinfo {
+
+// _____________________________________________________________________________________________________________________
+std::string read_usb_attribute(const std::string& device_path, const char* attribute) {
+  std::ifstream file(device_path + attribute);
+  std::string value;
+  if (file) {
+    std::getline(file, value);
+  }
+  return value;
+}
+
+// _____________________________________________________________________________________________________________________
+double parse_usb_number(const std::string& value, double fallback) {
+  // " 2.00", "480", "1.5"
+  char* end = nullptr;
+  double number = std::strtod(value.c_str(), &end);
+  return end == value.c_str() ? fallback : number;
+}
+
+// _____________________________________________________________________________________________________________________
+bool has_superspeed_capability(const std::string& bos) {
+  // BOS descriptor (bLength, bDescriptorType 0x0f, wTotalLength, bNumDeviceCaps), followed by the device capability
+  // descriptors (bLength, bDescriptorType 0x10, bDevCapabilityType, ...)
+  if (bos.size() < 5 || static_cast<uint8_t>(bos[1]) != 0x0f) {
+    return false;
+  }
+  for (size_t offset = static_cast<uint8_t>(bos[0]); offset + 3 <= bos.size();) {
+    const auto length = static_cast<uint8_t>(bos[offset]);
+    const auto capability = static_cast<uint8_t>(bos[offset + 2]);
+    if (length < 3) {
+      return false;
+    }
+    // 0x03: SuperSpeed USB, 0x0a: SuperSpeedPlus USB
+    if (static_cast<uint8_t>(bos[offset + 1]) == 0x10 && (capability == 0x03 || capability == 0x0a)) {
+      return true;
+    }
+    offset += length;
+  }
+  return false;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<USBDevice> getAllUSBDevices(const std::string& sysfs_root) {
+  std::vector<USBDevice> devices;
+  const std::string bus_path(sysfs_root + "/bus/usb/devices/");
+  std::shared_ptr<const USBMapper> usb;
+  for (const auto& entry : filesystem::getDirectoryEntries(bus_path)) {
+    if (entry.find(':') != std::string::npos) {
+      // interface ("1-1.2:1.0")
+      continue;
+    }
+    const std::string path(bus_path + entry + '/');
+    const std::string vendor_id = read_usb_attribute(path, "idVendor");
+    if (vendor_id.empty()) {
+      continue;
+    }
+    USBDevice device;
+    device._path = entry;
+    device._vendor_id = static_cast<uint16_t>(std::strtoul(vendor_id.c_str(), nullptr, 16));
+    device._product_id =
+        static_cast<uint16_t>(std::strtoul(read_usb_attribute(path, "idProduct").c_str(), nullptr, 16));
+    device._bus_number = static_cast<int>(parse_usb_number(read_usb_attribute(path, "busnum"), -1));
+    device._device_number = static_cast<int>(parse_usb_number(read_usb_attribute(path, "devnum"), -1));
+    device._device_class =
+        static_cast<int>(std::strtol(read_usb_attribute(path, "bDeviceClass").c_str(), nullptr, 16));
+    device._usb_version = parse_usb_number(read_usb_attribute(path, "version"), -1);
+    device._speed_Mbps = parse_usb_number(read_usb_attribute(path, "speed"), -1);
+    device._serial_number = read_usb_attribute(path, "serial");
+    if (device._usb_version >= 3.0) {
+      device._superspeed_capable = true;
+    } else {
+      std::ifstream bos(path + "bos_descriptors", std::ios::binary);
+      device._superspeed_capable = bos && has_superspeed_capability(std::string(std::istreambuf_iterator<char>(bos),
+                                                                                std::istreambuf_iterator<char>()));
+    }
+    // "port" links to the port of the parent hub (not for root hubs), "peer" to its SuperSpeed/USB 2.0 twin
+    device._port_superspeed = device._speed_Mbps >= 5000 || filesystem::exists(path + "port/peer");
+
+    if (!usb) {
+      usb = USB::getMapper();
+    }
+    const PCINames names = usb->resolve({device._vendor_id, device._product_id, 0, 0});
+    const std::string manufacturer = names.vendor == nullptr ? read_usb_attribute(path, "manufacturer") : "";
+    const std::string product = names.device == nullptr ? read_usb_attribute(path, "product") : "";
+    if (names.vendor != nullptr || !manufacturer.empty()) {
+      device._vendor = names.vendor != nullptr ? names.vendor : manufacturer;
+    }
+    if (names.device != nullptr || !product.empty()) {
+      device._name = names.device != nullptr ? names.device : product;
+    }
+    devices.push_back(std::move(device));
+  }
+  std::sort(devices.begin(), devices.end(), [](const USBDevice& a, const USBDevice& b) {
+    return a.busNumber() != b.busNumber() ? a.busNumber() < b.busNumber() : a.path() < b.path();
+  });
+  return devices;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
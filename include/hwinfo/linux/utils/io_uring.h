@@ -0,0 +1,202 @@
+#pragma once
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_UNIX
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+// IORING_OP_READ/WRITE came with the same kernel release (5.6) as this feature flag
+#ifdef IORING_FEAT_RW_CUR_POS
+#define HWINFO_HAS_IO_URING
+#endif
+#endif
+#endif
+
+#ifdef HWINFO_HAS_IO_URING
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+namespace hwinfo {
+namespace utils {
+
+/**
+ * Minimal io_uring submission/completion ring on top of the raw syscalls, so that no liburing is required.
+ * Only supports what the storage probe needs: plain reads and writes into caller owned buffers.
+ */
+class IoUring {
+ public:
+  explicit IoUring(unsigned entries) {
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+    io_uring_params params{};
+    _fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (_fd < 0) {
+      // not supported by the kernel or blocked (e.g. by seccomp in containers)
+      _fd = -1;
+      return;
+    }
+    _sq_entries = params.sq_entries;
+    _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap && _cq_ring_size > _sq_ring_size) {
+      _sq_ring_size = _cq_ring_size;
+    }
+    _sq_ring = mmap(nullptr, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+    if (_sq_ring == MAP_FAILED) {
+      _sq_ring = nullptr;
+      close_ring();
+      return;
+    }
+    if (single_mmap) {
+      _cq_ring = _sq_ring;
+    } else {
+      _cq_ring =
+          mmap(nullptr, _cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+      if (_cq_ring == MAP_FAILED) {
+        _cq_ring = nullptr;
+        close_ring();
+        return;
+      }
+    }
+    _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      close_ring();
+      return;
+    }
+    _sqes = static_cast<io_uring_sqe*>(sqes);
+
+    auto* sq = static_cast<char*>(_sq_ring);
+    _sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    _sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    _sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    _sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    auto* cq = static_cast<char*>(_cq_ring);
+    _cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    _cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    _cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+#else
+    (void)entries;
+#endif
+  }
+
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+
+  ~IoUring() { close_ring(); }
+
+  bool valid() const { return _fd >= 0; }
+
+  /**
+   * Queue a read (or write) of len bytes at offset. Returns false if the submission queue is full.
+   */
+  bool prepare(bool write, int fd, void* buffer, unsigned len, uint64_t offset, uint64_t user_data) {
+    unsigned tail = *_sq_tail;
+    unsigned head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+    if (tail - head >= _sq_entries) {
+      return false;
+    }
+    unsigned index = tail & *_sq_mask;
+    io_uring_sqe* sqe = &_sqes[index];
+    std::memset(sqe, 0, sizeof(io_uring_sqe));
+    sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    _sq_array[index] = index;
+    __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+    _pending++;
+    return true;
+  }
+
+  /**
+   * Submit all prepared entries and block until at least wait_nr completions are available.
+   * Returns the number of submitted entries or -errno.
+   */
+  int submit_and_wait(unsigned wait_nr) {
+#if defined(__NR_io_uring_enter)
+    int ret = static_cast<int>(syscall(__NR_io_uring_enter, _fd, _pending, wait_nr,
+                                       wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+    if (ret < 0) {
+      return -errno;
+    }
+    _pending -= static_cast<unsigned>(ret);
+    return ret;
+#else
+    (void)wait_nr;
+    return -1;
+#endif
+  }
+
+  /**
+   * Take one completion from the completion queue. Returns false if there is none.
+   */
+  bool pop(uint64_t& user_data, int& result) {
+    unsigned head = *_cq_head;
+    unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+      return false;
+    }
+    const io_uring_cqe& cqe = _cqes[head & *_cq_mask];
+    user_data = cqe.user_data;
+    result = cqe.res;
+    __atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+ private:
+  void close_ring() {
+    if (_sqes != nullptr) {
+      munmap(_sqes, _sqes_size);
+      _sqes = nullptr;
+    }
+    if (_cq_ring != nullptr && _cq_ring != _sq_ring) {
+      munmap(_cq_ring, _cq_ring_size);
+    }
+    _cq_ring = nullptr;
+    if (_sq_ring != nullptr) {
+      munmap(_sq_ring, _sq_ring_size);
+      _sq_ring = nullptr;
+    }
+    if (_fd >= 0) {
+      ::close(_fd);
+      _fd = -1;
+    }
+  }
+
+  int _fd{-1};
+  unsigned _sq_entries{0};
+  unsigned _pending{0};
+  void* _sq_ring{nullptr};
+  void* _cq_ring{nullptr};
+  size_t _sq_ring_size{0};
+  size_t _cq_ring_size{0};
+  size_t _sqes_size{0};
+  io_uring_sqe* _sqes{nullptr};
+  unsigned* _sq_head{nullptr};
+  unsigned* _sq_tail{nullptr};
+  unsigned* _sq_mask{nullptr};
+  unsigned* _sq_array{nullptr};
+  unsigned* _cq_head{nullptr};
+  unsigned* _cq_tail{nullptr};
+  unsigned* _cq_mask{nullptr};
+  io_uring_cqe* _cqes{nullptr};
+};
+
+}  // namespace utils
+}  // namespace hwinfo
+
+#endif  // HWINFO_HAS_IO_URING
+
+#endif  // HWINFO_UNIX
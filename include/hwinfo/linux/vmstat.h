@@ -0,0 +1,179 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "../platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "../vmstat.h"
+
+namespace hwinfo {
+
+struct VMStatKey {
+  const char* name;
+  uint64_t VMStat::*counter;
+  double VMStatRates::*rate;
+};
+
+static constexpr VMStatKey vmstat_keys[] = {
+    {"pgfault", &VMStat::pgfault, &VMStatRates::pgfault},
+    {"pgmajfault", &VMStat::pgmajfault, &VMStatRates::pgmajfault},
+    {"pswpin", &VMStat::pswpin, &VMStatRates::pswpin},
+    {"pswpout", &VMStat::pswpout, &VMStatRates::pswpout},
+    {"pgscan_direct", &VMStat::pgscan_direct, &VMStatRates::pgscan_direct},
+    {"pgscan_kswapd", &VMStat::pgscan_kswapd, &VMStatRates::pgscan_kswapd},
+    {"pgsteal_direct", &VMStat::pgsteal_direct, &VMStatRates::pgsteal_direct},
+    {"pgsteal_kswapd", &VMStat::pgsteal_kswapd, &VMStatRates::pgsteal_kswapd},
+    {"compact_stall", &VMStat::compact_stall, &VMStatRates::compact_stall},
+    {"thp_fault_alloc", &VMStat::thp_fault_alloc, &VMStatRates::thp_fault_alloc},
+    {"thp_fault_fallback", &VMStat::thp_fault_fallback, &VMStatRates::thp_fault_fallback},
+    {"numa_hit", &VMStat::numa_hit, &VMStatRates::numa_hit},
+    {"numa_miss", &VMStat::numa_miss, &VMStatRates::numa_miss},
+    {"numa_foreign", &VMStat::numa_foreign, &VMStatRates::numa_foreign},
+};
+
+// _____________________________________________________________________________________________________________________
+int64_t vmstat_clock_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// _____________________________________________________________________________________________________________________
+VMStatSampler::VMStatSampler(const char* path) : _fd(open(path, O_RDONLY | O_CLOEXEC)) {
+  _previous = read();
+  _previous_ns = vmstat_clock_ns();
+}
+
+// _____________________________________________________________________________________________________________________
+VMStatSampler::~VMStatSampler() {
+  if (_fd >= 0) {
+    close(_fd);
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+bool VMStatSampler::build_index(const char* begin, const char* end) {
+  // "<name> <value>\n" per line
+  _lines.clear();
+  const size_t num_keys = sizeof(vmstat_keys) / sizeof(vmstat_keys[0]);
+  for (const char* line = begin; line < end;) {
+    const char* line_end = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+    if (line_end == nullptr) {
+      line_end = end;
+    }
+    const char* space = static_cast<const char*>(std::memchr(line, ' ', static_cast<size_t>(line_end - line)));
+    if (space == nullptr || space - line > 255) {
+      _lines.clear();
+      return false;
+    }
+    const auto name_length = static_cast<size_t>(space - line);
+    Line indexed{-1, static_cast<uint8_t>(name_length)};
+    for (size_t key = 0; key < num_keys; ++key) {
+      if (std::strlen(vmstat_keys[key].name) == name_length &&
+          std::memcmp(vmstat_keys[key].name, line, name_length) == 0) {
+        indexed.key = static_cast<int8_t>(key);
+        break;
+      }
+    }
+    _lines.push_back(indexed);
+    line = line_end + 1;
+  }
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+bool VMStatSampler::parse_indexed(const char* begin, const char* end, VMStat& stat) const {
+  size_t index = 0;
+  for (const char* line = begin; line < end; ++index) {
+    if (index >= _lines.size()) {
+      return false;
+    }
+    const Line& indexed = _lines[index];
+    const char* value = line + indexed.name_length;
+    if (value >= end || *value != ' ') {
+      return false;
+    }
+    ++value;
+    uint64_t number = 0;
+    while (value < end && *value >= '0' && *value <= '9') {
+      number = number * 10 + static_cast<uint64_t>(*value++ - '0');
+    }
+    if (indexed.key >= 0) {
+      stat.*vmstat_keys[indexed.key].counter = number;
+    }
+    // values are unsigned, but skip to the end of the line in case of a signed one ("-1")
+    const char* line_end = static_cast<const char*>(std::memchr(value, '\n', static_cast<size_t>(end - value)));
+    line = line_end == nullptr ? end : line_end + 1;
+  }
+  return index == _lines.size();
+}
+
+// _____________________________________________________________________________________________________________________
+VMStat VMStatSampler::read() {
+  VMStat stat;
+  if (_fd < 0) {
+    return stat;
+  }
+  // a seq_file returns at most about one page per read (the vmstat of a NUMA kernel with all options is larger):
+  // read until the end. The buffer keeps the size of the largest read, later samples do not allocate.
+  if (_buffer.empty()) {
+    _buffer.resize(16384);
+  }
+  size_t size = 0;
+  for (;;) {
+    if (size == _buffer.size()) {
+      _buffer.resize(_buffer.size() * 2);
+    }
+    const ssize_t n = pread(_fd, _buffer.data() + size, _buffer.size() - size, static_cast<off_t>(size));
+    if (n < 0) {
+      return stat;
+    }
+    if (n == 0) {
+      break;
+    }
+    size += static_cast<size_t>(n);
+  }
+  if (size == 0) {
+    return stat;
+  }
+  const char* buffer = _buffer.data();
+  const char* end = buffer + size;
+  // the layout only changes with the kernel; re-index if it does not match anyway
+  if (_lines.empty() || !parse_indexed(buffer, end, stat)) {
+    stat = VMStat();
+    if (build_index(buffer, end)) {
+      parse_indexed(buffer, end, stat);
+    }
+  }
+  return stat;
+}
+
+// _____________________________________________________________________________________________________________________
+VMStatRates VMStatSampler::sample() {
+  const VMStat current = read();
+  const int64_t now_ns = vmstat_clock_ns();
+  VMStatRates rates;
+  rates.interval_s = static_cast<double>(now_ns - _previous_ns) / 1e9;
+  if (rates.interval_s > 0) {
+    for (const auto& key : vmstat_keys) {
+      const uint64_t before = _previous.*key.counter;
+      const uint64_t after = current.*key.counter;
+      rates.*key.rate = after >= before ? static_cast<double>(after - before) / rates.interval_s : 0;
+    }
+  }
+  _previous = current;
+  _previous_ns = now_ns;
+  return rates;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
@@ -0,0 +1,102 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include "platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hwinfo {
+
+// hugetlb pages of one size (counts of pages, -1 if not reported)
+struct HugePagePool {
+  int64_t page_size_Bytes{-1};
+  // nr_hugepages: pages in the pool, allocated or not
+  int64_t total{-1};
+  int64_t free{-1};
+  // pages allocated beyond the pool through overcommit
+  int64_t surplus{-1};
+  // reserved for mappings but not faulted in yet; system wide only
+  int64_t reserved{-1};
+  // nr_overcommit_hugepages; system wide only
+  int64_t overcommit_limit{-1};
+};
+
+struct NodeHugePages {
+  int node{-1};
+  std::vector<HugePagePool> pools;
+};
+
+// a multi-size THP (mTHP) of kernel 6.8+; enabled is "always", "inherit", "madvise" or "never"
+struct TransparentHugePageSize {
+  int64_t page_size_Bytes{-1};
+  std::string enabled;
+  std::string shmem_enabled;
+};
+
+/**
+ * Settings of /sys/kernel/mm/transparent_hugepage. The strings are the selected value of the setting ("madvise" of
+ * "always [madvise] never"), empty if the kernel does not have it.
+ */
+struct TransparentHugePages {
+  // false if the kernel was built without THP
+  bool available{false};
+  // "always", "madvise" or "never"
+  std::string enabled;
+  // "always", "defer", "defer+madvise", "madvise" or "never"
+  std::string defrag;
+  std::string shmem_enabled;
+  // size of a PMD mapped THP (hpage_pmd_size), 2 MiB on x86_64
+  int64_t page_size_Bytes{-1};
+  std::vector<TransparentHugePageSize> sizes;
+};
+
+// the khugepaged thread, which collapses base pages into THPs in the background
+struct Khugepaged {
+  // khugepaged/defrag: whether khugepaged may compact memory to get huge pages
+  bool defrag{false};
+  int64_t pages_to_scan{-1};
+  int64_t scan_sleep_ms{-1};
+  int64_t alloc_sleep_ms{-1};
+  // empty, swapped out and shared PTEs a range may have and still be collapsed
+  int64_t max_ptes_none{-1};
+  int64_t max_ptes_swap{-1};
+  int64_t max_ptes_shared{-1};
+  int64_t full_scans{-1};
+  int64_t pages_collapsed{-1};
+};
+
+struct MemoryPages {
+  int64_t base_page_size_Bytes{-1};
+  // the base page size followed by the hugetlb page sizes, ascending
+  std::vector<int64_t> page_sizes_Bytes;
+  // system wide hugetlb pools, one per page size
+  std::vector<HugePagePool> huge_pages;
+  // per NUMA node, sorted by node; empty without NUMA support
+  std::vector<NodeHugePages> nodes;
+  TransparentHugePages transparent_huge_pages;
+  Khugepaged khugepaged;
+  // current THP usage from /proc/meminfo, -1 if not reported
+  int64_t anon_huge_pages_Bytes{-1};
+  int64_t shmem_huge_pages_Bytes{-1};
+  int64_t file_huge_pages_Bytes{-1};
+};
+
+/**
+ * Page sizes, hugetlb pools (system wide and per NUMA node), THP and khugepaged settings and THP usage, from
+ * <sysfs_root>/kernel/mm, <sysfs_root>/devices/system/node and <proc_root>/meminfo.
+ */
+MemoryPages getMemoryPages(const std::string& sysfs_root = "/sys", const std::string& proc_root = "/proc");
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
+
+#if defined(HWINFO_UNIX)
+#include "linux/memory_pages.h"
+#endif
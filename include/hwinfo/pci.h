@@ -0,0 +1,110 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include "platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hwinfo {
+
+/**
+ * A device on the PCI bus (not to be confused with PCIDevice, an entry of the PCI ID database).
+ */
+class PCIBusDevice {
+  friend std::vector<PCIBusDevice> getPCIDevicesOfClass(uint32_t class_code, uint32_t class_mask,
+                                                        const std::string& sysfs_root);
+
+ public:
+  ~PCIBusDevice() = default;
+
+  // "0000:01:00.0" (domain:bus:device.function)
+  HWI_NODISCARD const std::string& address() const { return _address; }
+  HWI_NODISCARD int domain() const { return _domain; }
+  HWI_NODISCARD int bus() const { return _bus; }
+  HWI_NODISCARD int device() const { return _device; }
+  HWI_NODISCARD int function() const { return _function; }
+  // base class, subclass and programming interface: 0x030000 is a VGA controller
+  HWI_NODISCARD uint32_t classCode() const { return _class_code; }
+  HWI_NODISCARD uint16_t vendorId() const { return _vendor_id; }
+  HWI_NODISCARD uint16_t deviceId() const { return _device_id; }
+  HWI_NODISCARD uint16_t subsystemVendorId() const { return _subsystem_vendor_id; }
+  HWI_NODISCARD uint16_t subsystemDeviceId() const { return _subsystem_device_id; }
+  HWI_NODISCARD const std::string& vendor() const { return _vendor; }
+  HWI_NODISCARD const std::string& name() const { return _name; }
+  HWI_NODISCARD const std::string& subsystemName() const { return _subsystem_name; }
+  // "Display controller", from the class section of pci.ids
+  HWI_NODISCARD const std::string& className() const { return _class_name; }
+  // "VGA compatible controller"
+  HWI_NODISCARD const std::string& subclassName() const { return _subclass_name; }
+  // bound kernel driver, empty if none
+  HWI_NODISCARD const std::string& driver() const { return _driver; }
+  // -1 if the platform has no NUMA information for the device
+  HWI_NODISCARD int numaNode() const { return _numa_node; }
+  // link attributes are -1 for devices without PCIe link (legacy PCI, virtual devices)
+  HWI_NODISCARD double currentLinkSpeed_GTps() const { return _current_link_speed_GTps; }
+  HWI_NODISCARD double maxLinkSpeed_GTps() const { return _max_link_speed_GTps; }
+  HWI_NODISCARD int currentLinkWidth() const { return _current_link_width; }
+  HWI_NODISCARD int maxLinkWidth() const { return _max_link_width; }
+  // number of MSI-X vectors currently allocated by the driver
+  HWI_NODISCARD int msixVectors() const { return _msix_vectors; }
+  /**
+   * true if the link trained below the speed or width the device supports, e.g. a x16 card running at x4 because of
+   * the slot or a bad riser. Note that GPUs lower the link speed (not the width) by themselves when idle.
+   */
+  HWI_NODISCARD bool linkDegraded() const {
+    return (_current_link_speed_GTps > 0 && _current_link_speed_GTps < _max_link_speed_GTps) ||
+           (_current_link_width > 0 && _current_link_width < _max_link_width);
+  }
+
+ private:
+  PCIBusDevice() = default;
+  std::string _address;
+  int _domain{0};
+  int _bus{0};
+  int _device{0};
+  int _function{0};
+  uint32_t _class_code{0};
+  uint16_t _vendor_id{0};
+  uint16_t _device_id{0};
+  uint16_t _subsystem_vendor_id{0};
+  uint16_t _subsystem_device_id{0};
+  std::string _vendor{"<unknown>"};
+  std::string _name{"<unknown>"};
+  std::string _subsystem_name{"<unknown>"};
+  std::string _class_name{"<unknown>"};
+  std::string _subclass_name{"<unknown>"};
+  std::string _driver;
+  int _numa_node{-1};
+  double _current_link_speed_GTps{-1};
+  double _max_link_speed_GTps{-1};
+  int _current_link_width{-1};
+  int _max_link_width{-1};
+  int _msix_vectors{0};
+};
+
+/**
+ * All devices in <sysfs_root>/bus/pci/devices, sorted by address. Names are resolved with PCI::getMapper().
+ */
+std::vector<PCIBusDevice> getAllPCIDevices(const std::string& sysfs_root = "/sys");
+
+/**
+ * Devices whose class code matches class_code in the bits of class_mask, e.g. (0x030000, 0xff0000) for all display
+ * controllers or (0x010802, 0xffffff) for NVMe controllers. Other devices are skipped after reading their class, so
+ * nothing else of them is read or resolved.
+ */
+std::vector<PCIBusDevice> getPCIDevicesOfClass(uint32_t class_code, uint32_t class_mask = 0xff0000,
+                                               const std::string& sysfs_root = "/sys");
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
+
+#if defined(HWINFO_UNIX)
+#include "linux/pci.h"
+#endif
@@ -0,0 +1,79 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include "platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <cstdint>
+#include <string>
+
+namespace hwinfo {
+
+enum class PressureResource { CPU, Memory, IO };
+
+// share of wall time in which tasks stalled on the resource, in percent over the last 10, 60 and 300 seconds
+struct PressureStall {
+  double avg10{-1};
+  double avg60{-1};
+  double avg300{-1};
+  // accumulated stall time
+  uint64_t total_us{0};
+};
+
+/**
+ * Pressure stall information (PSI) of one resource. "some": at least one task stalled, "full": all non-idle tasks
+ * stalled at the same time (always 0 for the CPU at system level).
+ */
+struct Pressure {
+  // false if the kernel has no PSI (CONFIG_PSI, psi=1) or the file cannot be read
+  bool available{false};
+  PressureStall some;
+  PressureStall full;
+};
+
+// system wide pressure from <proc_root>/pressure/{cpu,memory,io}
+Pressure getPressure(PressureResource resource, const std::string& proc_root = "/proc");
+
+// pressure of the tasks of a cgroup v2 directory (e.g. "/sys/fs/cgroup/system.slice"), from {cpu,memory,io}.pressure
+Pressure getCgroupPressure(PressureResource resource, const std::string& cgroup_path);
+
+/**
+ * A PSI trigger: the kernel wakes wait() (or an epoll/poll on fd() for POLLPRI) once the stall time within a window
+ * exceeds a threshold, at most once per window. Nothing has to be polled in between.
+ */
+class PressureTrigger {
+ public:
+  /**
+   * Register a trigger on pressure_file (/proc/pressure/<resource> or <cgroup>/<resource>.pressure) for "some" (or
+   * "full") stalls of at least threshold_us within window_us. The window must be 500ms to 10s; without
+   * CAP_SYS_RESOURCE, the kernel only accepts windows that are a multiple of 2s. Throws std::runtime_error if the
+   * kernel rejects the trigger.
+   */
+  PressureTrigger(const std::string& pressure_file, bool full, int64_t threshold_us, int64_t window_us);
+  ~PressureTrigger();
+  PressureTrigger(const PressureTrigger&) = delete;
+  PressureTrigger& operator=(const PressureTrigger&) = delete;
+  PressureTrigger(PressureTrigger&& other) noexcept : _fd(other._fd) { other._fd = -1; }
+
+  /**
+   * Block until the trigger fires (true) or timeout_ms passed (false, -1 waits forever). Throws std::runtime_error if
+   * the monitored cgroup was removed.
+   */
+  bool wait(int timeout_ms = -1) const;
+  // file descriptor to wait on for POLLPRI (EPOLLPRI) in an existing event loop
+  HWI_NODISCARD int fd() const { return _fd; }
+
+ private:
+  int _fd{-1};
+};
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
+
+#if defined(HWINFO_UNIX)
+#include "linux/pressure.h"
+#endif
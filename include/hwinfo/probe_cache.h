@@ -0,0 +1,198 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include "platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "utils/env.h"
+#include "utils/stringutils.h"
+
+namespace hwinfo {
+
+/**
+ * Fingerprint (64 bit FNV-1a hash as hex string) of the hardware and software configuration that measurement results
+ * depend on: CPU model, microcode, topology, memory configuration (total size, NUMA nodes and, if the SMBIOS table
+ * is readable, the populated modules with their size and speed) and kernel version.
+ */
+std::string getHardwareFingerprint();
+
+/**
+ * Text describing the components the hardware fingerprint is computed from, one "key=value" per line.
+ */
+std::string getHardwareFingerprintSource();
+
+/**
+ * Small persistent key/value store for results of measurement probes, which take seconds to run.
+ * Entries are bound to the hardware fingerprint they were stored with: if the fingerprint of the running system
+ * differs from the one in the cache file, all entries are dropped on load.
+ *
+ * File format: a "fingerprint <hex>" line followed by one "<key>\t<value>" line per entry.
+ */
+class ProbeCache {
+ public:
+  explicit ProbeCache(std::string path = defaultPath()) : ProbeCache(std::move(path), getHardwareFingerprint()) {}
+
+  ProbeCache(std::string path, std::string fingerprint)
+      : _path(std::move(path)), _fingerprint(std::move(fingerprint)) {
+    load();
+  }
+
+  ~ProbeCache() = default;
+
+  /**
+   * $HOME/.hwinfo/probe_cache, empty if no home directory is set (the cache then is in-memory only).
+   */
+  static std::string defaultPath() {
+    std::string directory = utils::get_hwinfo_directory();
+    return directory.empty() ? "" : directory + "/probe_cache";
+  }
+
+  const std::string& path() const { return _path; }
+  const std::string& fingerprint() const { return _fingerprint; }
+  // true if a cache file existed but was written on a different hardware configuration
+  bool invalidated() const { return _invalidated; }
+  size_t size() const { return _entries.size(); }
+
+  bool get(const std::string& key, std::string& value) const {
+    auto it = _entries.find(key);
+    if (it == _entries.end()) {
+      return false;
+    }
+    value = it->second;
+    return true;
+  }
+
+  bool get(const std::string& key, std::vector<double>& values) const {
+    std::string text;
+    if (!get(key, text)) {
+      return false;
+    }
+    values.clear();
+    std::istringstream stream(text);
+    double value = 0;
+    while (stream >> value) {
+      values.push_back(value);
+    }
+    return true;
+  }
+
+  bool get(const std::string& key, double& value) const {
+    std::vector<double> values;
+    if (!get(key, values) || values.size() != 1) {
+      return false;
+    }
+    value = values[0];
+    return true;
+  }
+
+  /**
+   * Store value under key. Returns false if key contains a tab or a line break, or value contains a line break.
+   */
+  bool put(const std::string& key, const std::string& value) {
+    if (key.empty() || key.find_first_of("\t\r\n") != std::string::npos ||
+        value.find_first_of("\r\n") != std::string::npos) {
+      return false;
+    }
+    _entries[key] = value;
+    return true;
+  }
+
+  bool put(const std::string& key, const std::vector<double>& values) {
+    std::ostringstream stream;
+    stream.precision(17);
+    for (size_t i = 0; i < values.size(); ++i) {
+      stream << (i == 0 ? "" : " ") << values[i];
+    }
+    return put(key, stream.str());
+  }
+
+  bool put(const std::string& key, double value) { return put(key, std::vector<double>{value}); }
+
+  void erase(const std::string& key) { _entries.erase(key); }
+
+  void clear() { _entries.clear(); }
+
+  /**
+   * Write the cache file. The file is replaced atomically, so concurrent readers never see a partial file.
+   * Returns false if the file could not be written (e.g. read-only home directory).
+   */
+  bool save() const {
+    if (_path.empty()) {
+      return false;
+    }
+    auto slash = _path.rfind('/');
+    if (slash != std::string::npos && slash > 0) {
+      mkdir(_path.substr(0, slash).c_str(), 0755);
+    }
+    const std::string tmp_path(_path + ".tmp" + std::to_string(getpid()));
+    {
+      std::ofstream file(tmp_path, std::ios::trunc);
+      if (!file) {
+        return false;
+      }
+      file << "fingerprint " << _fingerprint << '\n';
+      for (const auto& entry : _entries) {
+        file << entry.first << '\t' << entry.second << '\n';
+      }
+      if (!file.flush()) {
+        std::remove(tmp_path.c_str());
+        return false;
+      }
+    }
+    if (std::rename(tmp_path.c_str(), _path.c_str()) != 0) {
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  void load() {
+    if (_path.empty()) {
+      return;
+    }
+    std::ifstream file(_path);
+    if (!file) {
+      return;
+    }
+    std::string line;
+    if (!std::getline(file, line) || line != "fingerprint " + _fingerprint) {
+      _invalidated = true;
+      return;
+    }
+    while (std::getline(file, line)) {
+      auto tab = line.find('\t');
+      if (tab == std::string::npos || tab == 0) {
+        continue;
+      }
+      _entries[line.substr(0, tab)] = line.substr(tab + 1);
+    }
+  }
+
+  std::string _path;
+  std::string _fingerprint;
+  bool _invalidated{false};
+  std::map<std::string, std::string> _entries;
+};
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
+
+#if defined(HWINFO_UNIX)
+#include "linux/probe_cache.h"
+#endif
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "platform.h"
+
 #if defined(unix) || defined(__unix) || defined(__unix__)
 #include <unistd.h>
 #elif defined(__APPLE__)
@@ -15,9 +17,117 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
+
+#include "smbios.h"
 
 namespace hwinfo {
 
+#ifdef HWINFO_UNIX
+/**
+ * Snapshot of /proc/meminfo with a field for every key of current kernels (fs/proc/meminfo.c with all options, and
+ * the DirectMap keys of x86, powerpc and s390). Sizes are in bytes, HugePages_* are page counts; -1 for keys the
+ * kernel does not report. Keys without field (later kernel versions) are skipped.
+ */
+struct MemInfo {
+  int64_t total_Bytes{-1};
+  int64_t free_Bytes{-1};
+  int64_t available_Bytes{-1};
+  int64_t buffers_Bytes{-1};
+  int64_t cached_Bytes{-1};
+  int64_t swap_cached_Bytes{-1};
+  int64_t active_Bytes{-1};
+  int64_t inactive_Bytes{-1};
+  int64_t active_anon_Bytes{-1};
+  int64_t inactive_anon_Bytes{-1};
+  int64_t active_file_Bytes{-1};
+  int64_t inactive_file_Bytes{-1};
+  int64_t unevictable_Bytes{-1};
+  int64_t mlocked_Bytes{-1};
+  // 32 bit kernels with highmem
+  int64_t high_total_Bytes{-1};
+  int64_t high_free_Bytes{-1};
+  int64_t low_total_Bytes{-1};
+  int64_t low_free_Bytes{-1};
+  // kernels without MMU
+  int64_t mmap_copy_Bytes{-1};
+  int64_t swap_total_Bytes{-1};
+  int64_t swap_free_Bytes{-1};
+  int64_t zswap_Bytes{-1};
+  int64_t zswapped_Bytes{-1};
+  int64_t dirty_Bytes{-1};
+  int64_t writeback_Bytes{-1};
+  int64_t anon_pages_Bytes{-1};
+  int64_t mapped_Bytes{-1};
+  int64_t shmem_Bytes{-1};
+  int64_t kreclaimable_Bytes{-1};
+  int64_t slab_Bytes{-1};
+  int64_t sreclaimable_Bytes{-1};
+  int64_t sunreclaim_Bytes{-1};
+  int64_t kernel_stack_Bytes{-1};
+  // arm64 with shadow call stacks
+  int64_t shadow_call_stack_Bytes{-1};
+  int64_t page_tables_Bytes{-1};
+  int64_t sec_page_tables_Bytes{-1};
+  int64_t nfs_unstable_Bytes{-1};
+  int64_t bounce_Bytes{-1};
+  int64_t writeback_tmp_Bytes{-1};
+  int64_t commit_limit_Bytes{-1};
+  int64_t committed_as_Bytes{-1};
+  int64_t vmalloc_total_Bytes{-1};
+  int64_t vmalloc_used_Bytes{-1};
+  int64_t vmalloc_chunk_Bytes{-1};
+  int64_t percpu_Bytes{-1};
+  int64_t hardware_corrupted_Bytes{-1};
+  int64_t anon_huge_pages_Bytes{-1};
+  int64_t shmem_huge_pages_Bytes{-1};
+  int64_t shmem_pmd_mapped_Bytes{-1};
+  int64_t file_huge_pages_Bytes{-1};
+  int64_t file_pmd_mapped_Bytes{-1};
+  int64_t cma_total_Bytes{-1};
+  int64_t cma_free_Bytes{-1};
+  int64_t unaccepted_Bytes{-1};
+  int64_t balloon_Bytes{-1};
+  int64_t hugepages_total{-1};
+  int64_t hugepages_free{-1};
+  int64_t hugepages_reserved{-1};
+  int64_t hugepages_surplus{-1};
+  int64_t hugepage_size_Bytes{-1};
+  int64_t hugetlb_Bytes{-1};
+  // memory of the kernel's direct mapping by page size (x86; 4M: 32 bit without PAE, 64k: powerpc, 1M/2G: s390):
+  // small entries left by splits cost TLB reach
+  int64_t direct_map_4k_Bytes{-1};
+  int64_t direct_map_64k_Bytes{-1};
+  int64_t direct_map_1M_Bytes{-1};
+  int64_t direct_map_2M_Bytes{-1};
+  int64_t direct_map_4M_Bytes{-1};
+  int64_t direct_map_1G_Bytes{-1};
+  int64_t direct_map_2G_Bytes{-1};
+};
+
+/**
+ * Read path (/proc/meminfo format) with a single pread into a stack buffer. Does not allocate; all fields are -1 if
+ * the file cannot be read.
+ */
+MemInfo getMemInfo(const char* path = "/proc/meminfo");
+
+/**
+ * Keeps /proc/meminfo open for repeated snapshots: one pread per sample().
+ */
+class MemInfoSampler {
+ public:
+  explicit MemInfoSampler(const char* path = "/proc/meminfo");
+  ~MemInfoSampler();
+  MemInfoSampler(const MemInfoSampler&) = delete;
+  MemInfoSampler& operator=(const MemInfoSampler&) = delete;
+
+  MemInfo sample() const;
+
+ private:
+  int _fd{-1};
+};
+#endif
+
 class RAM {
  public:
   RAM();
@@ -30,6 +140,14 @@ class RAM {
   int64_t total_Bytes() const { return _total_Bytes; }
   int64_t free_Bytes() const { return _free_Bytes; }
   int64_t available_Bytes() const { return _available_Bytes; }
+  // configured transfer rate of the first module in MT/s (DDR4-3200: 3200), -1 if unknown
+  int speed_MTps() const { return _frequency; }
+#ifdef HWINFO_UNIX
+  // the complete /proc/meminfo at construction
+  const MemInfo& memInfo() const { return _mem_info; }
+  // memory arrays and modules from the SMBIOS table (read once per process), empty without root privileges
+  const SMBIOSMemory& modules() const;
+#endif
 
  private:
   std::string _vendor{};
@@ -40,8 +158,43 @@ class RAM {
   int64_t _free_Bytes = -1;
   int64_t _available_Bytes = -1;
   int _frequency = -1;
+#ifdef HWINFO_UNIX
+  MemInfo _mem_info{};
+#endif
+};
+
+#ifdef HWINFO_UNIX
+enum class PageBacking { Base, TransparentHuge, HugeTLB_2M, HugeTLB_1G };
+
+struct PageBackingMeasurement {
+  PageBacking backing{PageBacking::Base};
+  int64_t page_size_Bytes{-1};
+  // false if the buffer could not be mapped with this backing (e.g. no hugetlb pages configured)
+  bool available{false};
+  // bytes of the used buffer (buffer_Bytes, not the mapping rounded to the page size) that actually are backed by huge
+  // pages (AnonHugePages in /proc/self/smaps for THP)
+  int64_t huge_Bytes{0};
+  // average cost of one random access
+  double access_ns{-1};
+  // access_ns of the 4K backed buffer minus access_ns of this backing
+  double saved_ns{0};
+};
+
+struct HugePageProbe {
+  int64_t buffer_Bytes{-1};
+  // true if the kernel backed (part of) the madvise(MADV_HUGEPAGE) buffer with transparent huge pages
+  bool thp_granted{false};
+  std::vector<PageBackingMeasurement> measurements;
 };
 
+/**
+ * Measure the cost of dependent random accesses (one per 4K page, in random order) over a buffer of buffer_Bytes that
+ * is backed by 4K pages, by transparent huge pages and by explicit 2M/1G hugetlb pages, if they are configured.
+ * The difference between the backings is the cost of TLB misses and page walks the huge pages save.
+ */
+HugePageProbe probeHugePages(int64_t buffer_Bytes = 1024 * 1024 * 1024, int64_t accesses = 4 * 1024 * 1024);
+#endif
+
 }  // namespace hwinfo
 
 #if defined(HWINFO_APPLE)
@@ -0,0 +1,343 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include "platform.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace hwinfo {
+
+// SMBIOS type 16 (Physical Memory Array): a set of memory slots, mostly one per CPU socket
+struct MemoryArray {
+  uint16_t handle{0};
+  // 0x03: system board, see the SMBIOS specification for the others
+  int location{-1};
+  // 0x03: system memory, 0x04: video memory, ...
+  int use{-1};
+  // 0x03: none, 0x05: single-bit ECC, 0x06: multi-bit ECC, ...
+  int error_correction{-1};
+  int64_t max_capacity_Bytes{-1};
+  int num_slots{-1};
+};
+
+// SMBIOS type 17 (Memory Device): one memory slot, populated or not
+struct MemoryDevice {
+  uint16_t handle{0};
+  // handle of the MemoryArray the slot belongs to
+  uint16_t array_handle{0};
+  // "DIMM_A1", "ChannelA-DIMM0", ...
+  std::string locator;
+  std::string bank_locator;
+  // 0 for an empty slot, -1 if unknown
+  int64_t size_Bytes{-1};
+  // "DDR4", "DDR5", "LPDDR5", ...
+  std::string type;
+  // rated and configured (actual) transfer rate
+  int64_t speed_MTps{-1};
+  int64_t configured_speed_MTps{-1};
+  std::string manufacturer;
+  std::string serial_number;
+  std::string part_number;
+  // -1 if unknown
+  int rank{-1};
+  int data_width_bits{-1};
+  int total_width_bits{-1};
+  int configured_voltage_mV{-1};
+
+  HWI_NODISCARD bool populated() const { return size_Bytes > 0; }
+};
+
+struct SMBIOSMemory {
+  // from the entry point, -1 if it was not given
+  int version_major{-1};
+  int version_minor{-1};
+  std::vector<MemoryArray> arrays;
+  std::vector<MemoryDevice> devices;
+
+  HWI_NODISCARD int populatedSlots() const {
+    int populated = 0;
+    for (const auto& device : devices) {
+      populated += device.populated() ? 1 : 0;
+    }
+    return populated;
+  }
+
+  /**
+   * false if the memory is populated in a way that costs bandwidth. SMBIOS does not name channels, so this is a
+   * heuristic on the slots of each memory array (mostly one array per socket):
+   *  - populated modules differ in size, rank or configured speed
+   *  - an array holds no module while another one does (a socket without local memory)
+   *  - the modules of an array cannot be spread evenly over its slots (3 of 4, 6 of 8), or occupy less than half of
+   *    them (2 of 8), which leaves channels empty
+   *  - a single module in an array with more slots: it runs single channel. A board with one slot per array (some
+   *    laptops) is balanced with its single module.
+   * Arrays that are not system memory are ignored.
+   */
+  HWI_NODISCARD bool balanced() const {
+    const MemoryDevice* first = nullptr;
+    struct ArrayPopulation {
+      uint16_t handle;
+      int slots;
+      int populated;
+    };
+    std::vector<ArrayPopulation> populations;
+    for (const auto& device : devices) {
+      const auto array = std::find_if(arrays.begin(), arrays.end(),
+                                      [&device](const MemoryArray& a) { return a.handle == device.array_handle; });
+      if (array != arrays.end() && array->use != -1 && array->use != 0x03) {
+        // not system memory (video memory, flash, ...)
+        continue;
+      }
+      auto population = std::find_if(populations.begin(), populations.end(), [&device](const ArrayPopulation& a) {
+        return a.handle == device.array_handle;
+      });
+      if (population == populations.end()) {
+        populations.push_back({device.array_handle, 0, 0});
+        population = populations.end() - 1;
+      }
+      population->slots++;
+      if (!device.populated()) {
+        continue;
+      }
+      population->populated++;
+      if (first == nullptr) {
+        first = &device;
+      } else if (device.size_Bytes != first->size_Bytes || device.rank != first->rank ||
+                 device.configured_speed_MTps != first->configured_speed_MTps) {
+        return false;
+      }
+    }
+    if (first == nullptr) {
+      // nothing populated (or nothing reported)
+      return true;
+    }
+    for (const auto& population : populations) {
+      if (population.populated == 0 || population.slots % population.populated != 0 ||
+          population.populated * 2 < population.slots || (population.populated == 1 && population.slots > 1)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+namespace smbios {
+
+inline uint16_t word(const uint8_t* p) { return static_cast<uint16_t>(p[0] | p[1] << 8); }
+
+inline uint32_t dword(const uint8_t* p) {
+  return static_cast<uint32_t>(word(p)) | static_cast<uint32_t>(word(p + 2)) << 16;
+}
+
+inline uint64_t qword(const uint8_t* p) {
+  return static_cast<uint64_t>(dword(p)) | static_cast<uint64_t>(dword(p + 4)) << 32;
+}
+
+/**
+ * String number index (1-based, 0: none) of the string set that follows the formatted area at strings, without
+ * trailing spaces.
+ */
+inline std::string string_at(const uint8_t* strings, const uint8_t* end, uint8_t index) {
+  if (index == 0) {
+    return "";
+  }
+  const uint8_t* p = strings;
+  for (uint8_t i = 1; i < index && p < end; ++i) {
+    const void* nul = std::memchr(p, '\0', static_cast<size_t>(end - p));
+    if (nul == nullptr) {
+      return "";
+    }
+    p = static_cast<const uint8_t*>(nul) + 1;
+    if (p < end && *p == '\0') {
+      // end of the string set
+      return "";
+    }
+  }
+  const void* nul = std::memchr(p, '\0', static_cast<size_t>(end - p));
+  if (p >= end || nul == nullptr) {
+    return "";
+  }
+  std::string value(reinterpret_cast<const char*>(p), static_cast<const uint8_t*>(nul) - p);
+  value.erase(value.find_last_not_of(' ') + 1);
+  return value;
+}
+
+inline std::string memory_type(uint8_t type) {
+  switch (type) {
+    case 0x12:
+      return "DDR";
+    case 0x13:
+      return "DDR2";
+    case 0x18:
+      return "DDR3";
+    case 0x1a:
+      return "DDR4";
+    case 0x1b:
+      return "LPDDR";
+    case 0x1c:
+      return "LPDDR2";
+    case 0x1d:
+      return "LPDDR3";
+    case 0x1e:
+      return "LPDDR4";
+    case 0x1f:
+      return "Logical non-volatile device";
+    case 0x20:
+      return "HBM";
+    case 0x21:
+      return "HBM2";
+    case 0x22:
+      return "DDR5";
+    case 0x23:
+      return "LPDDR5";
+    case 0x24:
+      return "HBM3";
+    default:
+      return "<unknown>";
+  }
+}
+
+inline MemoryArray parse_memory_array(const uint8_t* s, uint8_t length) {
+  MemoryArray array;
+  array.handle = word(s + 2);
+  if (length >= 0x0f) {
+    array.location = s[0x04];
+    array.use = s[0x05];
+    array.error_correction = s[0x06];
+    const uint32_t capacity_KiB = dword(s + 0x07);
+    if (capacity_KiB == 0x80000000u && length >= 0x17) {
+      // SMBIOS 2.7+: capacity in bytes
+      array.max_capacity_Bytes = static_cast<int64_t>(qword(s + 0x0f));
+    } else if (capacity_KiB != 0x80000000u) {
+      array.max_capacity_Bytes = static_cast<int64_t>(capacity_KiB) * 1024;
+    }
+    array.num_slots = word(s + 0x0d);
+  }
+  return array;
+}
+
+inline MemoryDevice parse_memory_device(const uint8_t* s, uint8_t length, const uint8_t* strings,
+                                        const uint8_t* end) {
+  // fields of later SMBIOS versions are only present if the structure is long enough
+  MemoryDevice device;
+  device.handle = word(s + 2);
+  if (length < 0x15) {
+    return device;
+  }
+  device.array_handle = word(s + 0x04);
+  const uint16_t total_width = word(s + 0x08);
+  const uint16_t data_width = word(s + 0x0a);
+  device.total_width_bits = total_width == 0xffff ? -1 : total_width;
+  device.data_width_bits = data_width == 0xffff ? -1 : data_width;
+  const uint16_t size = word(s + 0x0c);
+  if (size == 0x7fff && length >= 0x20) {
+    // SMBIOS 2.7+: extended size in MiB
+    device.size_Bytes = static_cast<int64_t>(dword(s + 0x1c) & 0x7fffffffu) * 1024 * 1024;
+  } else if (size != 0xffff) {
+    // bit 15: granularity KiB instead of MiB
+    device.size_Bytes = (size & 0x8000) ? static_cast<int64_t>(size & 0x7fff) * 1024
+                                        : static_cast<int64_t>(size) * 1024 * 1024;
+  }
+  device.locator = string_at(strings, end, s[0x10]);
+  device.bank_locator = string_at(strings, end, s[0x11]);
+  device.type = memory_type(s[0x12]);
+  if (length >= 0x17) {
+    const uint16_t speed = word(s + 0x15);
+    if (speed == 0xffff && length >= 0x58) {
+      device.speed_MTps = dword(s + 0x54);
+    } else if (speed != 0) {
+      device.speed_MTps = speed;
+    }
+  }
+  if (length >= 0x1b) {
+    device.manufacturer = string_at(strings, end, s[0x17]);
+    device.serial_number = string_at(strings, end, s[0x18]);
+    device.part_number = string_at(strings, end, s[0x1a]);
+  }
+  if (length >= 0x1c && (s[0x1b] & 0x0f) != 0) {
+    device.rank = s[0x1b] & 0x0f;
+  }
+  if (length >= 0x22) {
+    const uint16_t configured_speed = word(s + 0x20);
+    if (configured_speed == 0xffff && length >= 0x5c) {
+      device.configured_speed_MTps = dword(s + 0x58);
+    } else if (configured_speed != 0) {
+      device.configured_speed_MTps = configured_speed;
+    }
+  }
+  if (length >= 0x28 && word(s + 0x26) != 0) {
+    device.configured_voltage_mV = word(s + 0x26);
+  }
+  return device;
+}
+
+}  // namespace smbios
+
+/**
+ * Parse the memory arrays (type 16) and memory devices (type 17) of an SMBIOS structure table, e.g. the content of
+ * /sys/firmware/dmi/tables/DMI. entry_point (the content of smbios_entry_point, optional) provides the version and
+ * the length of the table.
+ */
+inline SMBIOSMemory parseSMBIOSMemory(const uint8_t* table, size_t table_size, const uint8_t* entry_point = nullptr,
+                                      size_t entry_point_size = 0) {
+  SMBIOSMemory memory;
+  if (entry_point != nullptr) {
+    if (entry_point_size >= 0x18 && std::memcmp(entry_point, "_SM3_", 5) == 0) {
+      memory.version_major = entry_point[0x07];
+      memory.version_minor = entry_point[0x08];
+      // maximal size of the table
+      table_size = std::min<size_t>(table_size, smbios::dword(entry_point + 0x0c));
+    } else if (entry_point_size >= 0x1f && std::memcmp(entry_point, "_SM_", 4) == 0) {
+      memory.version_major = entry_point[0x06];
+      memory.version_minor = entry_point[0x07];
+      table_size = std::min<size_t>(table_size, smbios::word(entry_point + 0x16));
+    }
+  }
+  const uint8_t* p = table;
+  const uint8_t* end = table + table_size;
+  while (p + 4 <= end) {
+    const uint8_t type = p[0];
+    const uint8_t length = p[1];
+    if (length < 4 || p + length > end) {
+      break;
+    }
+    // the string set ends with two null bytes
+    const uint8_t* strings = p + length;
+    const uint8_t* next = strings;
+    while (next + 1 < end && (next[0] != 0 || next[1] != 0)) {
+      ++next;
+    }
+    next = next + 1 < end ? next + 2 : end;
+    if (type == 16) {
+      memory.arrays.push_back(smbios::parse_memory_array(p, length));
+    } else if (type == 17) {
+      memory.devices.push_back(smbios::parse_memory_device(p, length, strings, next));
+    } else if (type == 127) {
+      // end of table
+      break;
+    }
+    p = next;
+  }
+  return memory;
+}
+
+#ifdef HWINFO_UNIX
+/**
+ * Memory arrays and devices from <sysfs_root>/firmware/dmi/tables. The table is only readable by root: without
+ * access, the result is empty.
+ */
+SMBIOSMemory getSMBIOSMemory(const std::string& sysfs_root = "/sys");
+#endif
+
+}  // namespace hwinfo
+
+#if defined(HWINFO_UNIX)
+#include "linux/smbios.h"
+#endif
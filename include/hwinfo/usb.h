@@ -0,0 +1,81 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include "platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hwinfo {
+
+class USBDevice {
+  friend std::vector<USBDevice> getAllUSBDevices(const std::string& sysfs_root);
+
+ public:
+  ~USBDevice() = default;
+
+  // topology path as named by the kernel: "<bus>-<port>.<port>...", e.g. "1-1.2" (or "usb1" for a root hub)
+  HWI_NODISCARD const std::string& path() const { return _path; }
+  HWI_NODISCARD int busNumber() const { return _bus_number; }
+  HWI_NODISCARD int deviceNumber() const { return _device_number; }
+  HWI_NODISCARD uint16_t vendorId() const { return _vendor_id; }
+  HWI_NODISCARD uint16_t productId() const { return _product_id; }
+  // from usb.ids, or the manufacturer/product strings reported by the device if it is not listed
+  HWI_NODISCARD const std::string& vendor() const { return _vendor; }
+  HWI_NODISCARD const std::string& name() const { return _name; }
+  HWI_NODISCARD const std::string& serialNumber() const { return _serial_number; }
+  HWI_NODISCARD int deviceClass() const { return _device_class; }
+  HWI_NODISCARD bool isHub() const { return _device_class == 9; }
+  // USB version the device implements (bcdUSB), e.g. 3.2
+  HWI_NODISCARD double usbVersion() const { return _usb_version; }
+  // negotiated signalling rate: 1.5, 12, 480, 5000, 10000, 20000; -1 if unknown
+  HWI_NODISCARD double speed_Mbps() const { return _speed_Mbps; }
+  /**
+   * true if the device can run at SuperSpeed: bcdUSB is 3.0 or later, or its BOS descriptor has a SuperSpeed (Plus) USB
+   * Device Capability. A SuperSpeed device that is connected at USB 2.0 speed reports bcdUSB 2.10, so only the BOS
+   * descriptor (sysfs "bos_descriptors", Linux 6.7+) tells for these.
+   */
+  HWI_NODISCARD bool superSpeedCapable() const { return _superspeed_capable; }
+  // true if the hub port the device is connected to has a SuperSpeed peer port, i.e. the port offers SuperSpeed
+  HWI_NODISCARD bool portSuperSpeed() const { return _port_superspeed; }
+  /**
+   * true if a SuperSpeed capable device (see superSpeedCapable()) runs at USB 2.0 speed or below: a USB 2.0 cable,
+   * hub or port (portSuperSpeed() is false for the latter two).
+   */
+  HWI_NODISCARD bool linkDegraded() const { return _superspeed_capable && _speed_Mbps > 0 && _speed_Mbps < 5000; }
+
+ private:
+  USBDevice() = default;
+  std::string _path;
+  int _bus_number{-1};
+  int _device_number{-1};
+  uint16_t _vendor_id{0};
+  uint16_t _product_id{0};
+  std::string _vendor{"<unknown>"};
+  std::string _name{"<unknown>"};
+  std::string _serial_number;
+  int _device_class{-1};
+  double _usb_version{-1};
+  double _speed_Mbps{-1};
+  bool _superspeed_capable{false};
+  bool _port_superspeed{false};
+};
+
+/**
+ * All USB devices (including root hubs, not interfaces) in <sysfs_root>/bus/usb/devices, sorted by path. Names are
+ * resolved with USB::getMapper().
+ */
+std::vector<USBDevice> getAllUSBDevices(const std::string& sysfs_root = "/sys");
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
+
+#if defined(HWINFO_UNIX)
+#include "linux/usb.h"
+#endif
@@ -0,0 +1,52 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <cstdlib>
+#include <string>
+
+namespace hwinfo {
+namespace utils {
+
+/**
+ * Value of the environment variable name, or an empty string if it is not set.
+ * @param name
+ * @return
+ */
+inline std::string get_env(const char* name) {
+#ifdef _MSC_VER
+  char* value = nullptr;
+  size_t size = 0;
+  if (_dupenv_s(&value, &size, name) != 0 || value == nullptr) {
+    return "";
+  }
+  std::string ret(value);
+  free(value);
+  return ret;
+#else
+  const char* value = std::getenv(name);
+  return value == nullptr ? "" : value;
+#endif
+}
+
+/**
+ * Directory hwinfo keeps its data files in ($HOME/.hwinfo, %USERPROFILE%\.hwinfo on Windows).
+ * Empty if no home directory is set, e.g. in sealed containers or system services.
+ * @return
+ */
+inline std::string get_hwinfo_directory() {
+  std::string home = get_env("HOME");
+#ifdef _WIN32
+  if (home.empty()) {
+    home = get_env("USERPROFILE");
+  }
+#endif
+  if (home.empty()) {
+    return "";
+  }
+  return home + "/.hwinfo";
+}
+
+}  // namespace utils
+}  // namespace hwinfo
@@ -0,0 +1,91 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include "platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <cstdint>
+#include <vector>
+
+namespace hwinfo {
+
+// counters of /proc/vmstat since boot (events, or pages for pswp*, pgscan*, pgsteal*)
+struct VMStat {
+  uint64_t pgfault{0};
+  uint64_t pgmajfault{0};
+  uint64_t pswpin{0};
+  uint64_t pswpout{0};
+  uint64_t pgscan_direct{0};
+  uint64_t pgscan_kswapd{0};
+  uint64_t pgsteal_direct{0};
+  uint64_t pgsteal_kswapd{0};
+  uint64_t compact_stall{0};
+  uint64_t thp_fault_alloc{0};
+  uint64_t thp_fault_fallback{0};
+  uint64_t numa_hit{0};
+  uint64_t numa_miss{0};
+  uint64_t numa_foreign{0};
+};
+
+// the VMStat counters per second over the interval between two samples
+struct VMStatRates {
+  double interval_s{0};
+  double pgfault{0};
+  double pgmajfault{0};
+  double pswpin{0};
+  double pswpout{0};
+  double pgscan_direct{0};
+  double pgscan_kswapd{0};
+  double pgsteal_direct{0};
+  double pgsteal_kswapd{0};
+  double compact_stall{0};
+  double thp_fault_alloc{0};
+  double thp_fault_fallback{0};
+  double numa_hit{0};
+  double numa_miss{0};
+  double numa_foreign{0};
+};
+
+/**
+ * Delta sampler over /proc/vmstat. The file is kept open and read with pread (until its end) per sample. The position
+ * of every counter is indexed at the first read, later reads parse the numbers at these lines without comparing keys.
+ */
+class VMStatSampler {
+ public:
+  explicit VMStatSampler(const char* path = "/proc/vmstat");
+  ~VMStatSampler();
+  VMStatSampler(const VMStatSampler&) = delete;
+  VMStatSampler& operator=(const VMStatSampler&) = delete;
+
+  // current counters
+  VMStat read();
+  // rates since the previous call of sample() (the first call: since construction)
+  VMStatRates sample();
+
+ private:
+  struct Line {
+    // index into the key table, -1 for counters that are not kept
+    int8_t key;
+    // length of the name, to detect a changed layout
+    uint8_t name_length;
+  };
+  bool build_index(const char* begin, const char* end);
+  bool parse_indexed(const char* begin, const char* end, VMStat& stat) const;
+
+  int _fd{-1};
+  std::vector<Line> _lines;
+  std::vector<char> _buffer;
+  VMStat _previous{};
+  int64_t _previous_ns{0};
+};
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
+
+#if defined(HWINFO_UNIX)
+#include "linux/vmstat.h"
+#endif
@@ -4,11 +4,18 @@ Author: Leon Freist <freist.leon@gmail.com>
 
 This script is used to build a compile time PCI ID mapper in C++.
 We use the pci.ids file (https://pci-ids.ucw.cz/v2.2/pci.ids) licenced under BSD3.
+
+usage: pci_builder.py [--pci-ids PATH] [--output HEADER]
+
+Writes a C++ header with the vendors, devices, subsystems and classes of pci.ids as sorted constexpr tables (the record
+types of hwinfo/PCIMapper.h). The header is compiled into hwinfo if it is configured with -DHWINFO_EMBED_PCI_IDS=ON.
 """
 
+import argparse
+import os
 import sys
 from dataclasses import dataclass, field
-from typing import Generator, Optional
+from typing import Dict, Generator, List, Optional, Tuple
 from collections import OrderedDict
 
 
@@ -38,13 +45,21 @@ class PCIParser:
         last_vendor: Optional[PCIVendor] = None
         last_device_id: str = ""
         for line in self.read_lines():
+            if line.startswith("C "):
+                # device classes follow, they are not part of the ID tables
+                break
             processed_line = line.strip()
+            if "  " not in processed_line:
+                continue
             _id, _info = processed_line.split("  ", maxsplit=1)
             if line.startswith('\t'):
+                if last_vendor is None:
+                    continue
                 # device or subsystem
                 if line.startswith("\t\t"):
                     # subsystem
-                    last_vendor.devices[last_device_id].subsystems[_id] = _info
+                    if last_device_id in last_vendor.devices:
+                        last_vendor.devices[last_device_id].subsystems[_id] = _info
                 else:
                     # device
                     last_vendor.devices[_id] = PCIDevice(_id, _info)
@@ -54,27 +69,163 @@ class PCIParser:
                     yield last_vendor
                 # vendor
                 last_vendor = PCIVendor(_id, _info)
+                last_device_id = ""
+        if last_vendor:
+            yield last_vendor
+
+    def parse_classes(self) -> List[Tuple[int, str]]:
+        """
+        (key, name) of the class section, key as in PCIClassRecord: level << 24 | class << 16 | subclass << 8 | prog-if
+        """
+        classes: List[Tuple[int, str]] = []
+        in_classes = False
+        class_code = subclass_code = -1
+        for line in self.read_lines():
+            if not in_classes:
+                if not line.startswith("C "):
+                    continue
+                in_classes = True
+            stripped = line.lstrip("\t")
+            depth = len(line) - len(stripped)
+            if depth == 0:
+                if not stripped.startswith("C "):
+                    # usb.ids: further sections follow the classes
+                    break
+                stripped = stripped[2:]
+            if "  " not in stripped:
+                continue
+            _id, _info = stripped.split("  ", maxsplit=1)
+            try:
+                code = int(_id, 16)
+            except ValueError:
+                continue
+            if depth == 0:
+                class_code, subclass_code = code, -1
+                classes.append((class_code << 16, _info.strip()))
+            elif depth == 1 and class_code >= 0:
+                subclass_code = code
+                classes.append((1 << 24 | class_code << 16 | subclass_code << 8, _info.strip()))
+            elif depth == 2 and subclass_code >= 0:
+                classes.append((2 << 24 | class_code << 16 | subclass_code << 8 | code, _info.strip()))
+        return sorted(classes)
 
     def read_lines(self) -> Generator[str, None, None]:
-        with open(self.in_path) as f:
+        with open(self.in_path, encoding="utf-8", errors="replace") as f:
             for line in f.readlines():
                 # skip all nonsense lines (comments and empty lines)
                 if line.startswith("#") or len(line) == 0 or line == '\n':
                     continue
-                yield line
+                yield line.rstrip("\r\n")
+
+
+def cpp_string(text: str) -> str:
+    """
+    C++ string literal for text. Non ASCII bytes are written as octal escapes, '?' is escaped to avoid trigraphs.
+    """
+    out = ['"']
+    for byte in text.encode("utf-8"):
+        char = chr(byte)
+        if char in '"\\?':
+            out.append("\\" + char)
+        elif 0x20 <= byte < 0x7f:
+            out.append(char)
+        else:
+            out.append(f"\\{byte:03o}")
+    out.append('"')
+    return "".join(out)
+
+
+class TableBuilder:
+    """
+    Flattens the parsed vendors into the sorted record tables of PCIMapper. Names are deduplicated and referenced by
+    index into a table of string literals.
+    """
+
+    def __init__(self, vendors: List[PCIVendor], classes: List[Tuple[int, str]]):
+        self.names: List[str] = []
+        self.name_index: Dict[str, int] = {}
+        self.vendors: List[str] = []
+        self.devices: List[str] = []
+        self.subsystems: List[str] = []
+        self.classes: List[str] = [f"{{0x{key:08x}, {self.name(name)}}}" for key, name in classes]
+        for vendor in sorted(vendors, key=lambda v: int(v.id, 16)):
+            devices = sorted(vendor.devices.values(), key=lambda d: int(d.id, 16))
+            self.vendors.append(f"{{0x{vendor.id}, {self.name(vendor.name)}, {len(self.devices)}, {len(devices)}}}")
+            for device in devices:
+                subsystems = sorted(((int(s[:4], 16), int(s[5:], 16), name) for s, name in device.subsystems.items()
+                                     if len(s) == 9))
+                self.devices.append(
+                    f"{{0x{device.id}, {self.name(device.name)}, {len(self.subsystems)}, {len(subsystems)}}}")
+                for subvendor_id, subdevice_id, name in subsystems:
+                    self.subsystems.append(f"{{0x{subvendor_id:04x}, 0x{subdevice_id:04x}, {self.name(name)}}}")
+
+    def name(self, text: str) -> int:
+        index = self.name_index.get(text)
+        if index is None:
+            index = len(self.names)
+            self.name_index[text] = index
+            self.names.append(text)
+        return index
+
+    def header(self, source: str) -> str:
+        def table(declaration: str, rows: List[str]) -> str:
+            # an empty aggregate array is ill-formed: keep one dummy row, the count passed to PCIMapper excludes it
+            body = ",\n".join(f"      {row}" for row in rows) if rows else "      {}"
+            return f"  {declaration}[] = {{\n{body}}};\n"
+
+        return (
+            "// Generated by scripts/pci_builder.py from " + os.path.basename(source) + ". Do not edit.\n"
+            "\n"
+            "#pragma once\n"
+            "\n"
+            "#include <memory>\n"
+            "\n"
+            "namespace hwinfo {\n"
+            "namespace pci {\n"
+            "\n"
+            "/**\n"
+            " * PCIMapper on the compiled in tables. The tables are function local statics, so they exist once per\n"
+            " * program even if this header is included in several translation units.\n"
+            " */\n"
+            "inline std::shared_ptr<const PCIMapper> embedded_mapper() {\n"
+            + table("static constexpr PCIVendorRecord vendors", self.vendors)
+            + table("static constexpr PCIDeviceRecord devices", self.devices)
+            + table("static constexpr PCISubsystemRecord subsystems", self.subsystems)
+            + table("static constexpr PCIClassRecord classes", self.classes)
+            + table("static const char* const names", [cpp_string(name) for name in self.names])
+            + f"  return std::make_shared<const PCIMapper>(vendors, {len(self.vendors)}, devices, {len(self.devices)},"
+            f"\n                                           subsystems, {len(self.subsystems)}, classes, {len(self.classes)},"
+            " names);\n"
+            "}\n"
+            "\n"
+            "}  // namespace pci\n"
+            "}  // namespace hwinfo\n")
+
+
+def find_pci_ids() -> Optional[str]:
+    for path in ("pci.ids", "scripts/pci.ids", "hwinfo/scripts/pci.ids"):
+        if os.path.isfile(path):
+            return path
+    return None
 
 
 if __name__ == "__main__":
-    import os
-    path = "pci.ids"
-    if not os.path.isfile(path):
-        path = "scripts/pci.ids"
-    if not os.path.isfile(path):
-        path = "hwinfo/scripts/pci.ids"
-    else:
-        print("pci.ids file could not be found")
+    arg_parser = argparse.ArgumentParser(description="Generate the compile time PCI ID tables of hwinfo.")
+    arg_parser.add_argument("--pci-ids", help="pci.ids file (default: search pci.ids, scripts/pci.ids, ...)")
+    arg_parser.add_argument("--output", help="header to write (default: stdout)")
+    args = arg_parser.parse_args()
+
+    path = args.pci_ids or find_pci_ids()
+    if path is None or not os.path.isfile(path):
+        print("pci.ids file could not be found", file=sys.stderr)
         exit(1)
     parser = PCIParser(path)
-    for vendor in parser.parse():
-        print(f"{'{'}{vendor.id}")
-
+    header = TableBuilder(list(parser.parse()), parser.parse_classes()).header(path)
+    if args.output is None:
+        sys.stdout.write(header)
+    else:
+        os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+        # only touch the header if it changed, so that dependent sources are not rebuilt needlessly
+        if not os.path.isfile(args.output) or open(args.output, encoding="utf-8").read() != header:
+            with open(args.output, "w", encoding="utf-8") as f:
+                f.write(header)
@@ -0,0 +1,70 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+// Tests of GPUSampler on data/gpu, a sysfs tree with an amdgpu card (busy percent and VRAM on the PCI device, clock,
+// power, temperature and fan in hwmon) and an i915 card (clock on the card node, nothing else).
+
+// gpu.h on its own runs into the include order of the cpu and filesystem utilities
+#include <hwinfo/hwinfo.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK_EQ(actual, expected)                                                                     \
+  do {                                                                                                 \
+    if (!((actual) == (expected))) {                                                                   \
+      std::cerr << __FILE__ << ':' << __LINE__ << ": " #actual " == " #expected " failed (" << (actual) \
+                << ")\n";                                                                              \
+      failures++;                                                                                      \
+    }                                                                                                  \
+  } while (false)
+
+// _____________________________________________________________________________________________________________________
+void test_sampler() {
+  hwinfo::GPUSampler sampler(std::string(HWINFO_TEST_DATA) + "/gpu");
+  // card0 and renderD128 are one GPU, card0-DP-1 is a connector
+  CHECK_EQ(sampler.size(), 2u);
+  const std::vector<hwinfo::GPUSample>& samples = sampler.sample();
+  if (samples.size() != 2) {
+    return;
+  }
+  const hwinfo::GPUSample& amdgpu = samples[0];
+  CHECK_EQ(amdgpu.id, 0);
+  CHECK_EQ(amdgpu.busy_percent, 87);
+  CHECK_EQ(amdgpu.vram_used_Bytes, 6442450944);
+  CHECK_EQ(amdgpu.vram_total_Bytes, 17163091968);
+  // hwmon: Hz, microwatt, millidegree Celsius
+  CHECK_EQ(amdgpu.frequency_MHz, 2405);
+  CHECK_EQ(amdgpu.power_W, 215.0);
+  CHECK_EQ(amdgpu.temperature_C, 68.0);
+  CHECK_EQ(amdgpu.fan_RPM[0], 1850);
+  CHECK_EQ(amdgpu.fan_RPM[1], -1);
+
+  const hwinfo::GPUSample& i915 = samples[1];
+  CHECK_EQ(i915.id, 1);
+  // the actual frequency, not the requested one
+  CHECK_EQ(i915.frequency_MHz, 1300);
+  CHECK_EQ(i915.busy_percent, -1);
+  CHECK_EQ(i915.vram_used_Bytes, -1);
+  CHECK_EQ(i915.vram_total_Bytes, -1);
+  CHECK_EQ(i915.power_W, -1.0);
+  CHECK_EQ(i915.temperature_C, -1.0);
+
+  // the files stay open, a second sample reads them again
+  CHECK_EQ(sampler.sample()[0].busy_percent, 87);
+}
+
+// _____________________________________________________________________________________________________________________
+int main() {
+  test_sampler();
+  CHECK_EQ(hwinfo::GPUSampler(std::string(HWINFO_TEST_DATA) + "/missing").size(), 0u);
+  if (failures > 0) {
+    std::cerr << failures << " checks failed\n";
+    return 1;
+  }
+  std::cout << "all checks passed\n";
+  return 0;
+}
@@ -0,0 +1,218 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+// Tests of parseSMBIOSMemory() on the tables in data/smbios (DMI and smbios_entry_point as the kernel exports them in
+// /sys/firmware/dmi/tables) and of SMBIOSMemory::balanced().
+
+#include <hwinfo/smbios.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK_EQ(actual, expected)                                                                     \
+  do {                                                                                                 \
+    if (!((actual) == (expected))) {                                                                   \
+      std::cerr << __FILE__ << ':' << __LINE__ << ": " #actual " == " #expected " failed (" << (actual) \
+                << ")\n";                                                                              \
+      failures++;                                                                                      \
+    }                                                                                                  \
+  } while (false)
+
+static const int64_t MiB = 1024 * 1024;
+static const int64_t GiB = 1024 * MiB;
+
+// _____________________________________________________________________________________________________________________
+std::vector<uint8_t> read_file(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    std::cerr << "cannot read " << path << '\n';
+    failures++;
+    return {};
+  }
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// _____________________________________________________________________________________________________________________
+hwinfo::SMBIOSMemory parse(const std::string& name) {
+  const std::string path = std::string(HWINFO_TEST_DATA) + "/smbios/" + name + "/firmware/dmi/tables/";
+  const std::vector<uint8_t> table = read_file(path + "DMI");
+  const std::vector<uint8_t> entry_point = read_file(path + "smbios_entry_point");
+  return hwinfo::parseSMBIOSMemory(table.data(), table.size(), entry_point.data(), entry_point.size());
+}
+
+// _____________________________________________________________________________________________________________________
+void test_smbios2_single_dimm() {
+  // "_SM_" entry point, SMBIOS 2.8
+  const hwinfo::SMBIOSMemory memory = parse("smbios2_single_dimm");
+  CHECK_EQ(memory.version_major, 2);
+  CHECK_EQ(memory.version_minor, 8);
+  CHECK_EQ(memory.arrays.size(), 1u);
+  CHECK_EQ(memory.arrays[0].num_slots, 2);
+  CHECK_EQ(memory.arrays[0].max_capacity_Bytes, 16 * GiB);
+  CHECK_EQ(memory.devices.size(), 2u);
+  const hwinfo::MemoryDevice& dimm = memory.devices[0];
+  CHECK_EQ(dimm.locator, "ChannelA-DIMM0");
+  CHECK_EQ(dimm.bank_locator, "BANK 0");
+  CHECK_EQ(dimm.size_Bytes, 8 * GiB);
+  CHECK_EQ(dimm.type, "DDR3");
+  CHECK_EQ(dimm.speed_MTps, 1600);
+  CHECK_EQ(dimm.configured_speed_MTps, 1600);
+  CHECK_EQ(dimm.rank, 2);
+  CHECK_EQ(dimm.manufacturer, "Samsung");
+  CHECK_EQ(dimm.part_number, "M471B1G73DB0-YK0");
+  CHECK_EQ(dimm.configured_voltage_mV, 1350);
+  CHECK_EQ(memory.devices[1].locator, "ChannelB-DIMM0");
+  CHECK_EQ(memory.devices[1].populated(), false);
+  CHECK_EQ(memory.populatedSlots(), 1);
+  // one module on a dual channel board
+  CHECK_EQ(memory.balanced(), false);
+}
+
+// _____________________________________________________________________________________________________________________
+void test_smbios3_two_sockets() {
+  // "_SM3_" entry point, SMBIOS 3.3, 32 GiB modules need the extended size field
+  const hwinfo::SMBIOSMemory memory = parse("smbios3_two_sockets");
+  CHECK_EQ(memory.version_major, 3);
+  CHECK_EQ(memory.version_minor, 3);
+  CHECK_EQ(memory.arrays.size(), 2u);
+  CHECK_EQ(memory.arrays[1].max_capacity_Bytes, 1024 * GiB);
+  CHECK_EQ(memory.devices.size(), 8u);
+  CHECK_EQ(memory.populatedSlots(), 4);
+  const hwinfo::MemoryDevice& dimm = memory.devices[6];
+  CHECK_EQ(dimm.locator, "P2-DIMMC1");
+  CHECK_EQ(dimm.array_handle, memory.arrays[1].handle);
+  CHECK_EQ(dimm.size_Bytes, 32 * GiB);
+  CHECK_EQ(dimm.type, "DDR4");
+  CHECK_EQ(dimm.speed_MTps, 3200);
+  CHECK_EQ(dimm.configured_speed_MTps, 2933);
+  CHECK_EQ(dimm.rank, 2);
+  CHECK_EQ(dimm.manufacturer, "Micron");
+  // trailing spaces are stripped
+  CHECK_EQ(dimm.part_number, "36ASF4G72PZ-3G2E2");
+  CHECK_EQ(memory.devices[7].populated(), false);
+  CHECK_EQ(memory.balanced(), true);
+}
+
+// _____________________________________________________________________________________________________________________
+void test_smbios2_old_lengths() {
+  // SMBIOS 2.3 type 17 (no rank, no configured speed), SMBIOS 2.1 type 17 (no speed, no strings but the locators) and
+  // a table that ends within the last structure
+  const hwinfo::SMBIOSMemory memory = parse("smbios2_old_lengths");
+  CHECK_EQ(memory.version_major, 2);
+  CHECK_EQ(memory.version_minor, 3);
+  CHECK_EQ(memory.arrays.size(), 1u);
+  CHECK_EQ(memory.arrays[0].max_capacity_Bytes, 4 * GiB);
+  CHECK_EQ(memory.devices.size(), 2u);
+  CHECK_EQ(memory.devices[0].locator, "DIMM0");
+  CHECK_EQ(memory.devices[0].size_Bytes, 1024 * MiB);
+  CHECK_EQ(memory.devices[0].type, "DDR2");
+  CHECK_EQ(memory.devices[0].speed_MTps, 667);
+  CHECK_EQ(memory.devices[0].configured_speed_MTps, -1);
+  CHECK_EQ(memory.devices[0].rank, -1);
+  CHECK_EQ(memory.devices[0].part_number, "KVR667D2N5/1G");
+  CHECK_EQ(memory.devices[1].locator, "DIMM1");
+  CHECK_EQ(memory.devices[1].size_Bytes, 1024 * MiB);
+  CHECK_EQ(memory.devices[1].speed_MTps, -1);
+  CHECK_EQ(memory.devices[1].manufacturer, "");
+  // 2 of 4 slots with equal modules
+  CHECK_EQ(memory.balanced(), true);
+}
+
+// _____________________________________________________________________________________________________________________
+hwinfo::SMBIOSMemory population(const std::vector<std::vector<bool>>& arrays) {
+  // arrays of slots, true: an 16 GiB module
+  hwinfo::SMBIOSMemory memory;
+  for (size_t a = 0; a < arrays.size(); ++a) {
+    hwinfo::MemoryArray array;
+    array.handle = static_cast<uint16_t>(0x1000 + a);
+    array.use = 0x03;
+    array.num_slots = static_cast<int>(arrays[a].size());
+    memory.arrays.push_back(array);
+    for (bool populated : arrays[a]) {
+      hwinfo::MemoryDevice device;
+      device.array_handle = array.handle;
+      device.size_Bytes = populated ? 16 * GiB : 0;
+      device.configured_speed_MTps = populated ? 3200 : -1;
+      device.rank = populated ? 1 : -1;
+      memory.devices.push_back(device);
+    }
+  }
+  return memory;
+}
+
+// _____________________________________________________________________________________________________________________
+void test_balanced() {
+  CHECK_EQ(population({{true, false}}).balanced(), false);
+  CHECK_EQ(population({{true, false, false, false}}).balanced(), false);
+  CHECK_EQ(population({{true, true, true, false}}).balanced(), false);
+  CHECK_EQ(population({{true, false, true, false}}).balanced(), true);
+  CHECK_EQ(population({{true, true, true, true}}).balanced(), true);
+  // a board with a single slot
+  CHECK_EQ(population({{true}}).balanced(), true);
+  // 2 of 8 slots leave channels empty
+  CHECK_EQ(population({{true, false, false, false, true, false, false, false}}).balanced(), false);
+  // 8 of 16 modules, all on the first socket
+  const std::vector<bool> full(8, true);
+  const std::vector<bool> empty(8, false);
+  CHECK_EQ(population({full, empty}).balanced(), false);
+  CHECK_EQ(population({{true, false, true, false}, {true, false, true, false}}).balanced(), true);
+  // modules of different sizes
+  hwinfo::SMBIOSMemory mixed = population({{true, true}});
+  mixed.devices[1].size_Bytes = 8 * GiB;
+  CHECK_EQ(mixed.balanced(), false);
+  // arrays that are not system memory do not count
+  hwinfo::SMBIOSMemory video = population({{true, true}, {false}});
+  video.arrays[1].use = 0x04;
+  CHECK_EQ(video.balanced(), true);
+  CHECK_EQ(hwinfo::SMBIOSMemory().balanced(), true);
+}
+
+// _____________________________________________________________________________________________________________________
+void test_truncated_tables() {
+  // every prefix of a table parses without reading beyond it: each prefix is copied into a heap buffer of exactly its
+  // size, so that an overread is caught by AddressSanitizer or valgrind
+  const std::string path = std::string(HWINFO_TEST_DATA) + "/smbios/smbios3_two_sockets/firmware/dmi/tables/DMI";
+  const std::vector<uint8_t> table = read_file(path);
+  size_t previous = 0;
+  for (size_t size = 0; size <= table.size(); ++size) {
+    std::unique_ptr<uint8_t[]> prefix(new uint8_t[size]);
+    std::copy(table.begin(), table.begin() + static_cast<std::ptrdiff_t>(size), prefix.get());
+    const size_t devices = hwinfo::parseSMBIOSMemory(prefix.get(), size).devices.size();
+    // a device counts once its formatted area is in the prefix: no more devices than the full table has, and never
+    // fewer than a shorter prefix
+    if (devices > 8 || devices < previous) {
+      std::cerr << "prefix of " << size << " bytes: " << devices << " devices after " << previous << '\n';
+      failures++;
+    }
+    previous = devices;
+  }
+  CHECK_EQ(previous, 8u);
+}
+
+// _____________________________________________________________________________________________________________________
+int main() {
+  test_smbios2_single_dimm();
+  test_smbios3_two_sockets();
+  test_smbios2_old_lengths();
+  test_balanced();
+  test_truncated_tables();
+#ifdef HWINFO_UNIX
+  // the same table through the sysfs reader
+  CHECK_EQ(hwinfo::getSMBIOSMemory(std::string(HWINFO_TEST_DATA) + "/smbios/smbios3_two_sockets").devices.size(), 8u);
+#endif
+  if (failures > 0) {
+    std::cerr << failures << " checks failed\n";
+    return 1;
+  }
+  std::cout << "all checks passed\n";
+  return 0;
+}
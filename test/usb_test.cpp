@@ -0,0 +1,86 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+// Tests of getAllUSBDevices() on data/usb, a sysfs tree with an xHCI controller (USB 2.0 and SuperSpeed root hub with
+// peered ports) and devices that run at the speed they can, or fell back to USB 2.0. The hub interfaces are named
+// "1-0_1.0" instead of "1-0:1.0" (':' is not allowed in Windows paths).
+
+// usb.h on its own runs into the include order of the cpu and filesystem utilities
+#include <hwinfo/hwinfo.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK_EQ(actual, expected)                                                                     \
+  do {                                                                                                 \
+    if (!((actual) == (expected))) {                                                                   \
+      std::cerr << __FILE__ << ':' << __LINE__ << ": " #actual " == " #expected " failed (" << (actual) \
+                << ")\n";                                                                              \
+      failures++;                                                                                      \
+    }                                                                                                  \
+  } while (false)
+
+// _____________________________________________________________________________________________________________________
+void test_devices() {
+  const std::vector<hwinfo::USBDevice> devices = hwinfo::getAllUSBDevices(std::string(HWINFO_TEST_DATA) + "/usb");
+  CHECK_EQ(devices.size(), 6u);
+  if (devices.size() != 6) {
+    return;
+  }
+  // sorted by bus, then path
+  const hwinfo::USBDevice& stick = devices[0];
+  CHECK_EQ(stick.path(), "1-1");
+  CHECK_EQ(stick.busNumber(), 1);
+  CHECK_EQ(stick.deviceNumber(), 2);
+  CHECK_EQ(stick.vendorId(), 0x0781);
+  CHECK_EQ(stick.productId(), 0x5583);
+  // a SuperSpeed device at 480 Mbit/s reports bcdUSB 2.10, its BOS descriptor has the SuperSpeed capability
+  CHECK_EQ(stick.usbVersion(), 2.1);
+  CHECK_EQ(stick.speed_Mbps(), 480.0);
+  CHECK_EQ(stick.superSpeedCapable(), true);
+  CHECK_EQ(stick.portSuperSpeed(), true);
+  CHECK_EQ(stick.linkDegraded(), true);
+
+  // USB 2.0 device with bcdUSB 2.10 (Link Power Management) on a USB 3 port
+  const hwinfo::USBDevice& receiver = devices[1];
+  CHECK_EQ(receiver.path(), "1-2");
+  CHECK_EQ(receiver.usbVersion(), 2.1);
+  CHECK_EQ(receiver.superSpeedCapable(), false);
+  CHECK_EQ(receiver.portSuperSpeed(), true);
+  CHECK_EQ(receiver.linkDegraded(), false);
+
+  // SuperSpeed device on a USB 2.0 only port
+  const hwinfo::USBDevice& adapter = devices[2];
+  CHECK_EQ(adapter.path(), "1-3");
+  CHECK_EQ(adapter.superSpeedCapable(), true);
+  CHECK_EQ(adapter.portSuperSpeed(), false);
+  CHECK_EQ(adapter.linkDegraded(), true);
+
+  const hwinfo::USBDevice& root_hub = devices[3];
+  CHECK_EQ(root_hub.path(), "usb1");
+  CHECK_EQ(root_hub.isHub(), true);
+  CHECK_EQ(root_hub.linkDegraded(), false);
+
+  const hwinfo::USBDevice& superspeed = devices[4];
+  CHECK_EQ(superspeed.path(), "2-1");
+  CHECK_EQ(superspeed.usbVersion(), 3.2);
+  CHECK_EQ(superspeed.speed_Mbps(), 5000.0);
+  CHECK_EQ(superspeed.superSpeedCapable(), true);
+  CHECK_EQ(superspeed.portSuperSpeed(), true);
+  CHECK_EQ(superspeed.linkDegraded(), false);
+  CHECK_EQ(devices[5].path(), "usb2");
+}
+
+// _____________________________________________________________________________________________________________________
+int main() {
+  test_devices();
+  if (failures > 0) {
+    std::cerr << failures << " checks failed\n";
+    return 1;
+  }
+  std::cout << "all checks passed\n";
+  return 0;
+}
@@ -0,0 +1,71 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+// Tests of VMStatSampler on data/vmstat/vmstat, a /proc/vmstat of 5 KiB (a kernel with NUMA, THP, zswap and the
+// counters of a long running machine): the THP counters are beyond the first 4 KiB.
+
+#include <hwinfo/vmstat.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+static int failures = 0;
+
+#define CHECK_EQ(actual, expected)                                                                     \
+  do {                                                                                                 \
+    if (!((actual) == (expected))) {                                                                   \
+      std::cerr << __FILE__ << ':' << __LINE__ << ": " #actual " == " #expected " failed (" << (actual) \
+                << ")\n";                                                                              \
+      failures++;                                                                                      \
+    }                                                                                                  \
+  } while (false)
+
+// _____________________________________________________________________________________________________________________
+void test_read() {
+  const std::string path = std::string(HWINFO_TEST_DATA) + "/vmstat/vmstat";
+  hwinfo::VMStatSampler sampler(path.c_str());
+  // twice: the first read builds the index, the second one parses through it
+  for (int i = 0; i < 2; ++i) {
+    const hwinfo::VMStat stat = sampler.read();
+    CHECK_EQ(stat.numa_hit, 123456789012u);
+    CHECK_EQ(stat.numa_miss, 98765u);
+    CHECK_EQ(stat.numa_foreign, 98766u);
+    CHECK_EQ(stat.pswpin, 4096u);
+    CHECK_EQ(stat.pswpout, 8192u);
+    CHECK_EQ(stat.pgfault, 98765432101u);
+    CHECK_EQ(stat.pgmajfault, 1234567u);
+    CHECK_EQ(stat.pgsteal_kswapd, 345678901u);
+    CHECK_EQ(stat.pgsteal_direct, 2345678u);
+    CHECK_EQ(stat.pgscan_kswapd, 456789012u);
+    CHECK_EQ(stat.pgscan_direct, 3456789u);
+    CHECK_EQ(stat.compact_stall, 7654u);
+    CHECK_EQ(stat.thp_fault_alloc, 8765432u);
+    // not mixed up with thp_fault_fallback_charge in the next line
+    CHECK_EQ(stat.thp_fault_fallback, 54321u);
+  }
+  // the file does not change: no events
+  const hwinfo::VMStatRates rates = sampler.sample();
+  CHECK_EQ(rates.pgfault, 0.0);
+  CHECK_EQ(rates.thp_fault_alloc, 0.0);
+}
+
+// _____________________________________________________________________________________________________________________
+void test_missing_file() {
+  const std::string path = std::string(HWINFO_TEST_DATA) + "/vmstat/missing";
+  hwinfo::VMStatSampler sampler(path.c_str());
+  CHECK_EQ(sampler.read().pgfault, 0u);
+  CHECK_EQ(sampler.sample().pgfault, 0.0);
+}
+
+// _____________________________________________________________________________________________________________________
+int main() {
+  test_read();
+  test_missing_file();
+  if (failures > 0) {
+    std::cerr << failures << " checks failed\n";
+    return 1;
+  }
+  std::cout << "all checks passed\n";
+  return 0;
+}